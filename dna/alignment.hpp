@@ -0,0 +1,68 @@
+#pragma once
+
+#include "anchor.hpp"
+#include "compare.hpp"
+
+namespace dna
+{
+
+// Where two helices start to line up, and where the usable part of each one
+// ends (the start of its tail telomeres).
+struct alignment_frame
+{
+	std::size_t lhs_begin;
+	std::size_t rhs_begin;
+	std::size_t lhs_end;
+	std::size_t rhs_end;
+
+	constexpr long offset() const noexcept
+	{
+		return static_cast<long>(rhs_begin) - static_cast<long>(lhs_begin);
+	}
+
+	constexpr std::size_t length() const noexcept
+	{
+		auto lhs = lhs_end > lhs_begin ? lhs_end - lhs_begin : 0;
+		auto rhs = rhs_end > rhs_begin ? rhs_end - rhs_begin : 0;
+		return std::min(lhs, rhs);
+	}
+};
+
+// Lines two helices up on the end of their head telomeres. When either one
+// lost its telomeres the offset comes from seed anchors instead; if even that
+// fails both sides start right after whatever telomere is left.
+template<HelixStream S>
+alignment_frame frame_helices(S& lhs, const telomere_bounds& lhs_telomeres, S& rhs, const telomere_bounds& rhs_telomeres)
+{
+	auto lhs_begin = static_cast<long>(lhs_telomeres.head_end);
+	auto rhs_begin = static_cast<long>(rhs_telomeres.head_end);
+
+	if (!lhs_telomeres.has_head() || !rhs_telomeres.has_head())
+	{
+		if (auto anchor = find_anchor_offset(lhs, lhs_telomeres.head_end, rhs, rhs_telomeres.head_end))
+		{
+			lhs_begin = std::max(lhs_begin, rhs_begin - anchor->offset);
+			rhs_begin = lhs_begin + anchor->offset;
+		}
+	}
+
+	return alignment_frame{static_cast<std::size_t>(lhs_begin), static_cast<std::size_t>(rhs_begin),
+			lhs_telomeres.tail_begin, rhs_telomeres.tail_begin};
+}
+
+template<HelixStream S>
+alignment_frame frame_helices(S& lhs, S& rhs)
+{
+	auto lhs_telomeres = find_telomeres(lhs);
+	auto rhs_telomeres = find_telomeres(rhs);
+	return frame_helices(lhs, lhs_telomeres, rhs, rhs_telomeres);
+}
+
+template<HelixStream S>
+aligned_range align_helices(S lhs, S rhs)
+{
+	auto frame = frame_helices(lhs, rhs);
+	return aligned_range{frame.lhs_begin, frame.rhs_begin, frame.length()};
+}
+
+}
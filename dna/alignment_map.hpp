@@ -0,0 +1,383 @@
+#pragma once
+
+#include "alignment.hpp"
+#include "myers.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t map_block_bases = std::size_t{1} << 16;
+static constexpr std::size_t desync_mismatches = 8;
+static constexpr std::size_t resync_window_bases = 4096;
+static constexpr std::size_t resync_search_bases = std::size_t{1} << 14;
+static constexpr std::size_t resync_stride = 8;
+static constexpr std::size_t suspicious_mismatches = 6;
+static constexpr std::size_t refine_band = 8;
+
+// Co-linear segments that each keep a constant offset. Whatever lies between
+// two consecutive segments is an insertion or a deletion.
+using alignment_map = std::vector<aligned_range>;
+
+namespace detail
+{
+
+struct sync_scan
+{
+	bool lost;
+	std::size_t position;
+};
+
+// Two consecutive words that mostly disagree mean the offset no longer holds;
+// scattered SNPs never get close to that. When the window ends on a single
+// bad word the scan stops there so the next window can confirm it.
+inline sync_scan scan_sync(const packed_sequence& lhs, std::size_t lhs_pos, const packed_sequence& rhs,
+		std::size_t rhs_pos, std::size_t count)
+{
+	std::optional<std::size_t> suspect;
+	for (std::size_t done = 0; done < count; done += word_bases)
+	{
+		auto mask = window_mask(lhs, lhs_pos, rhs, rhs_pos, done, count);
+		if (mismatch_count(mask) < desync_mismatches)
+		{
+			suspect.reset();
+			continue;
+		}
+
+		if (suspect)
+			return sync_scan{true, *suspect};
+		suspect = done + first_base(mask);
+	}
+	return sync_scan{false, suspect && *suspect > 0 ? *suspect : count};
+}
+
+// The offset seeds agree on for the bases from `at`, searched within
+// resync_search_bases of `offset`; nothing when no offset gets enough seeds.
+template<HelixStream S>
+std::optional<long> locate_offset(S& lhs, S& rhs, std::size_t at, long offset, std::size_t rhs_end)
+{
+	auto lhs_window = load_packed(lhs, at, resync_window_bases);
+
+	auto center = static_cast<long>(at) + offset;
+	auto from = static_cast<std::size_t>(std::max(0L, center - static_cast<long>(resync_search_bases)));
+	auto to = std::min(rhs_end, static_cast<std::size_t>(std::max(0L, center)) + resync_window_bases + resync_search_bases);
+	if (to <= from)
+		return std::nullopt;
+
+	auto rhs_window = load_packed(rhs, from, to - from);
+	auto anchor = find_anchor_offset(lhs_window, at, kmer_index(rhs_window, from), resync_stride);
+	if (!anchor)
+		return std::nullopt;
+	return anchor->offset;
+}
+
+// A new offset for the bases from `lost`, or nothing if seeds find none or
+// still agree with `offset`.
+template<HelixStream S>
+std::optional<long> resync_offset(S& lhs, S& rhs, std::size_t lost, long offset, std::size_t rhs_end)
+{
+	auto next = locate_offset(lhs, rhs, lost, offset, rhs_end);
+	if (!next || *next == offset)
+		return std::nullopt;
+	return next;
+}
+
+// The scan flags the first word that clearly disagrees, a few bases after
+// the indel itself. This picks the split point between `floor` and a little
+// past `lost` that leaves the fewest mismatches on either side, preferring
+// the leftmost one.
+template<HelixStream S>
+std::size_t refine_breakpoint(S& lhs, S& rhs, std::size_t floor, std::size_t lost, long offset, long next)
+{
+	auto shift = static_cast<std::size_t>(std::max(0L, offset - next));
+	auto from = std::max({floor, lost > 2 * word_bases ? lost - 2 * word_bases : 0,
+			static_cast<std::size_t>(std::max(0L, -next))});
+	auto count = lost + 2 * word_bases + shift - from;
+
+	auto lhs_window = load_packed(lhs, from, count);
+	auto old_window = load_packed(rhs, static_cast<std::size_t>(static_cast<long>(from) + offset), count);
+	auto new_window = load_packed(rhs, static_cast<std::size_t>(static_cast<long>(from) + next), count);
+	count = std::min({lhs_window.size(), old_window.size(), new_window.size()});
+	if (count <= shift)
+		return lost;
+
+	std::vector<std::size_t> old_prefix(count + 1, 0);
+	std::vector<std::size_t> new_suffix(count + 1, 0);
+	for (std::size_t i = 0; i < count; ++i)
+		old_prefix[i + 1] = old_prefix[i] + (lhs_window[i] != old_window[i]);
+	for (auto i = count; i > 0; --i)
+		new_suffix[i - 1] = new_suffix[i] + (lhs_window[i - 1] != new_window[i - 1]);
+
+	std::size_t best = 0;
+	for (std::size_t t = 1; t + shift <= count; ++t)
+	{
+		if (old_prefix[t] + new_suffix[t + shift] < old_prefix[best] + new_suffix[best + shift])
+			best = t;
+	}
+	return from + best;
+}
+
+// Indels in repeats can sit at several equivalent positions. Shifting left
+// while the base before the indel matches its last base gives every path the
+// same leftmost one. Pairings before the indel don't change, so whatever was
+// already reported for them stays valid.
+template<HelixStream S>
+std::size_t normalize_breakpoint(S& lhs, S& rhs, std::size_t floor, std::size_t split, long offset, long next)
+{
+	constexpr std::size_t step = 4 * word_bases;
+
+	auto& helix = next > offset ? rhs : lhs;
+	auto shift = static_cast<std::size_t>(next > offset ? next - offset : offset - next);
+	auto lead = next > offset ? offset : 0L;
+	floor = std::max(floor, static_cast<std::size_t>(std::max(0L, -lead)));
+
+	while (split > floor)
+	{
+		auto count = std::min(step, split - floor);
+		auto first = static_cast<std::size_t>(static_cast<long>(split - count) + lead);
+		auto window = load_packed(helix, first, count + shift);
+		if (window.size() < count + shift)
+			return split;
+
+		for (auto i = count; i > 0; --i, --split)
+		{
+			if (window[i - 1] != window[i - 1 + shift])
+				return split;
+		}
+	}
+	return split;
+}
+
+}
+
+// Where to go when the offset is lost and no nearby one takes over: the
+// segment closes at `split` and the walk resumes at `resume` under `offset`.
+struct sync_jump
+{
+	std::size_t split;
+	std::size_t resume;
+	long offset;
+};
+
+namespace detail
+{
+
+struct no_rescue
+{
+	std::optional<sync_jump> operator()(std::size_t, std::size_t, long) const noexcept
+	{
+		return std::nullopt;
+	}
+};
+
+}
+
+// Walks both helices with the XOR kernel and, wherever the current offset
+// stops holding, seeds the next few thousand bases to chain onto a new one.
+// Only the neighbourhood of an indel is ever indexed. When that fails,
+// rescue(segment, lost, offset) may still name a jump past the break.
+template<HelixStream S, typename R = detail::no_rescue>
+alignment_map map_alignment(S& lhs, S& rhs, const alignment_frame& frame, std::size_t block_bases = map_block_bases,
+		R&& rescue = R{})
+{
+	alignment_map map;
+	auto offset = frame.offset();
+	auto segment = frame.lhs_begin;
+	auto position = frame.lhs_begin;
+	std::optional<std::size_t> last_resync;
+
+	auto rhs_limit = [&]() { return static_cast<long>(frame.rhs_end) - offset; };
+	auto close = [&](std::size_t end)
+	{
+		end = std::min({end, frame.lhs_end, static_cast<std::size_t>(std::max(0L, rhs_limit()))});
+		if (end > segment)
+			map.push_back(aligned_range{segment, static_cast<std::size_t>(static_cast<long>(segment) + offset), end - segment});
+	};
+
+	while (position < frame.lhs_end && static_cast<long>(position) < rhs_limit())
+	{
+		auto count = std::min({block_bases, frame.lhs_end - position, static_cast<std::size_t>(rhs_limit()) - position});
+		auto lhs_block = load_packed(lhs, position, count);
+		auto rhs_block = load_packed(rhs, static_cast<std::size_t>(static_cast<long>(position) + offset), count);
+		count = std::min(lhs_block.size(), rhs_block.size());
+		if (count == 0)
+			break;
+
+		auto scan = detail::scan_sync(lhs_block, 0, rhs_block, 0, count);
+		if (!scan.lost)
+		{
+			position += scan.position;
+			continue;
+		}
+
+		auto lost = position + scan.position;
+		auto retry = !last_resync || lost > *last_resync;
+		auto next = retry ? detail::resync_offset(lhs, rhs, lost, offset, frame.rhs_end) : std::nullopt;
+		if (!next)
+		{
+			std::optional<sync_jump> jump;
+			if (retry)
+				jump = rescue(segment, lost, offset);
+
+			if (jump)
+			{
+				close(jump->split);
+				last_resync = lost;
+				segment = position = jump->resume;
+				offset = jump->offset;
+			}
+			else
+				position = lost + 2 * word_bases;
+			continue;
+		}
+
+		auto split = detail::refine_breakpoint(lhs, rhs, segment, lost, offset, *next);
+		split = detail::normalize_breakpoint(lhs, rhs, segment, split, offset, *next);
+		close(split);
+		last_resync = lost;
+		segment = position = split + static_cast<std::size_t>(std::max(0L, offset - *next));
+		offset = *next;
+	}
+
+	close(position);
+	return map;
+}
+
+// Reports what lies between two consecutive segments: bases present on both
+// sides are compared, the rest is an insertion or a deletion.
+template<HelixStream S, typename F>
+void compare_gap(S& lhs, S& rhs, std::size_t chromosome, const aligned_range& before, const aligned_range& after,
+		F&& emit)
+{
+	auto lhs_from = before.lhs + before.length;
+	auto rhs_from = before.rhs + before.length;
+	auto lhs_gap = after.lhs > lhs_from ? after.lhs - lhs_from : 0;
+	auto rhs_gap = after.rhs > rhs_from ? after.rhs - rhs_from : 0;
+	auto common = std::min(lhs_gap, rhs_gap);
+
+	if (common > 0)
+		compare_range(lhs, rhs, chromosome, aligned_range{lhs_from, rhs_from, common}, emit);
+
+	if (rhs_gap > common)
+	{
+		auto length = rhs_gap - common;
+		auto alternate = load_packed(rhs, rhs_from + common, std::min(length, word_bases)).word(0);
+		emit(difference{chromosome, lhs_from + common, length, rhs_from + common, difference_kind::insertion, alternate});
+	}
+	else if (lhs_gap > common)
+	{
+		emit(difference{chromosome, lhs_from + common, lhs_gap - common, rhs_from + common, difference_kind::deletion, 0});
+	}
+}
+
+namespace detail
+{
+
+// The refiner's clustering rule: `found` starts a new cluster when it lies
+// too far from the cluster's first difference to fit one Myers window with
+// it, or sits under another offset.
+inline bool breaks_cluster(const difference& front, const difference& found) noexcept
+{
+	return found.end() - front.start > myers_max_bases ||
+			found.other_start - found.start != front.other_start - front.start;
+}
+
+// Whether a cluster piling up `bases` mismatching bases gets realigned.
+constexpr bool suspicious_cluster(std::size_t bases) noexcept
+{
+	return bases >= suspicious_mismatches;
+}
+
+}
+
+// Holds back substitutions that fit in one Myers window. When a window piles
+// up mismatching bases it is realigned with the bit-vector kernel, and if a
+// few indels explain it better than the substitutions they are reported
+// instead. Sparse SNPs pass straight through.
+template<HelixStream S>
+class indel_refiner
+{
+	S& lhs_;
+	S& rhs_;
+	std::vector<difference> cluster_;
+	std::size_t bases_;
+public:
+	indel_refiner(S& lhs, S& rhs) :
+			lhs_(lhs),
+			rhs_(rhs),
+			cluster_(),
+			bases_(0)
+	{ }
+
+	template<typename F>
+	void push(const difference& found, F&& emit)
+	{
+		if (found.kind != difference_kind::substitution)
+		{
+			flush(emit);
+			emit(found);
+			return;
+		}
+
+		if (!cluster_.empty() && detail::breaks_cluster(cluster_.front(), found))
+			flush(emit);
+
+		cluster_.push_back(found);
+		bases_ += found.length;
+	}
+
+	template<typename F>
+	void flush(F&& emit)
+	{
+		if (!detail::suspicious_cluster(bases_) || !refine(emit))
+		{
+			for (const auto& found : cluster_)
+				emit(found);
+		}
+
+		cluster_.clear();
+		bases_ = 0;
+	}
+
+private:
+	template<typename F>
+	bool refine(F& emit)
+	{
+		const auto& first = cluster_.front();
+		auto length = cluster_.back().end() - first.start;
+		auto lhs_window = load_packed(lhs_, first.start, length);
+		auto rhs_window = load_packed(rhs_, first.other_start, length);
+
+		auto aligned = banded_align(lhs_window, 0, length, rhs_window, 0, length, refine_band);
+		if (!aligned || aligned->distance >= bases_)
+			return false;
+
+		for (const auto& edit : aligned->edits)
+		{
+			packed_word alternate = 0;
+			if (edit.kind != difference_kind::deletion)
+				alternate = rhs_window.word(edit.rhs) & (~packed_word{0} << (64 - 2 * std::min(edit.length, word_bases)));
+
+			emit(difference{first.chromosome, first.start + edit.lhs, edit.length, first.other_start + edit.rhs,
+					edit.kind, alternate});
+		}
+		return true;
+	}
+};
+
+template<HelixStream S, typename F>
+void compare_mapped(S& lhs, S& rhs, std::size_t chromosome, const alignment_map& map, F&& emit,
+		std::size_t chunk_bases = default_chunk_bases)
+{
+	indel_refiner<S> refiner(lhs, rhs);
+	auto refined = [&](const difference& found) { refiner.push(found, emit); };
+
+	for (std::size_t i = 0; i < map.size(); ++i)
+	{
+		if (i > 0)
+			compare_gap(lhs, rhs, chromosome, map[i - 1], map[i], refined);
+		compare_range(lhs, rhs, chromosome, map[i], refined, chunk_bases);
+	}
+	refiner.flush(emit);
+}
+
+}
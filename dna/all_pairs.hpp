@@ -0,0 +1,231 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include "cohort.hpp"
+
+namespace dna
+{
+
+// How all-pairs work is cut up: every person's next `range_bases` bases of a
+// chromosome, plus `margin_bases` on either side, are loaded once and shared
+// by all the pairs they are in. Pairs are then walked in blocks of
+// `block_people` by `block_people` so both sides of a block stay in cache.
+// The default margin covers a full resync search, so only pairs whose
+// offset has drifted further than that read outside the loaded ranges.
+struct pair_tiling
+{
+	std::size_t block_people = 32;
+	std::size_t range_bases = std::size_t{1} << 20;
+	std::size_t margin_bases = resync_search_bases + resync_window_bases;
+	std::size_t threads = default_threads();
+};
+
+namespace detail
+{
+
+struct pair_tile
+{
+	packed_sequence bases;
+	std::size_t origin;
+};
+
+constexpr std::size_t pair_index(std::size_t i, std::size_t j, std::size_t people) noexcept
+{
+	return i * (2 * people - i - 1) / 2 + (j - i - 1);
+}
+
+// A helix that serves reads from its person's current tile. The person's own
+// helix is only opened, once per copy, for bytes outside the tile; copies
+// share the tile but never the opened helix, so each pair lane stays a few
+// pointers until it actually drifts.
+template<Person P>
+class tile_helix
+{
+	using helix = helix_of<P>;
+	static constexpr std::size_t read_bytes = 4096;
+
+	const P* person_;
+	std::size_t chromosome_;
+	const pair_tile* tile_;
+	long size_;
+	std::size_t position_;
+	std::unique_ptr<helix> own_;
+	std::vector<std::byte> scratch_;
+public:
+	tile_helix(const P& person, std::size_t chromosome, const pair_tile& tile, long size) :
+			person_(&person),
+			chromosome_(chromosome),
+			tile_(&tile),
+			size_(size),
+			position_(0),
+			own_(),
+			scratch_()
+	{ }
+
+	tile_helix(const tile_helix& other) :
+			tile_helix(*other.person_, other.chromosome_, *other.tile_, other.size_)
+	{ }
+
+	void seek(long offset)
+	{
+		position_ = static_cast<std::size_t>(offset);
+	}
+
+	long size() const
+	{
+		return size_;
+	}
+
+	bool opened() const noexcept
+	{
+		return own_ != nullptr;
+	}
+
+	sequence_buffer<std::span<const std::byte>> read()
+	{
+		constexpr auto word_bytes = sizeof(packed_word);
+		auto first = tile_->origin / packed_size::value;
+		auto count = tile_->bases.size() / packed_size::value;
+
+		scratch_.clear();
+		if (position_ >= first && position_ < first + count)
+		{
+			const auto& words = tile_->bases.words();
+			auto last = std::min(first + count, position_ + read_bytes);
+			for (auto k = position_ - first; k < last - first; ++k)
+				scratch_.push_back(static_cast<std::byte>((words[k / word_bytes] >> (8 * (word_bytes - 1 - k % word_bytes))) & 0xff));
+		}
+		else if (position_ < static_cast<std::size_t>(size_))
+		{
+			if (!own_)
+				own_ = std::make_unique<helix>(person_->chromosome(chromosome_));
+			own_->seek(static_cast<long>(position_));
+			const auto chunk = own_->read();
+			const auto& bytes = chunk.buffer();
+			for (std::size_t i = 0; i < static_cast<std::size_t>(bytes.size()); ++i)
+				scratch_.push_back(bytes[i]);
+		}
+
+		position_ += scratch_.size();
+		return sequence_buffer<std::span<const std::byte>>(std::span<const std::byte>(scratch_));
+	}
+};
+
+}
+
+// Compares every pair of people. For each chromosome, ranges are taken in
+// order and every person's range is read once into a tile shared by all of
+// their pairs, so a cohort of N is read about once per person instead of
+// once per pair. The pair matrix is then walked block by block against the
+// tiles in memory, one task per pair of blocks and one round of workers per
+// range. Ranges are counted from each person's head telomeres.
+// Each pair only keeps a small lane (its offset, position and pending
+// substitutions); a pair whose offset drifts past the tile margin (long
+// indels) opens its own helices for the bases the tiles don't hold.
+//
+// emit(i, j, difference) is called with i < j, from worker threads, but
+// never concurrently for the same pair, and in order for any one pair.
+template<Person P, typename F>
+void compare_all_pairs(const std::vector<std::reference_wrapper<const P>>& people, F&& emit,
+		const pair_tiling& tiling = pair_tiling{})
+{
+	using helix = helix_of<P>;
+	using view = detail::tile_helix<P>;
+	using lane = detail::lockstep_target<view>;
+
+	auto count = people.size();
+	if (count < 2)
+		return;
+
+	auto chromosomes = people.front().get().chromosomes();
+	for (const auto& person : people)
+	{
+		if (person.get().chromosomes() != chromosomes)
+			throw std::invalid_argument("people do not have the same number of chromosomes");
+	}
+
+	auto blocks = (count + tiling.block_people - 1) / tiling.block_people;
+	std::vector<std::pair<std::size_t, std::size_t>> block_pairs;
+	for (std::size_t lhs_block = 0; lhs_block < blocks; ++lhs_block)
+		for (auto rhs_block = lhs_block; rhs_block < blocks; ++rhs_block)
+			block_pairs.emplace_back(lhs_block, rhs_block);
+
+	for (std::size_t chromosome = 0; chromosome < chromosomes; ++chromosome)
+	{
+		std::vector<telomere_bounds> bounds(count);
+		std::vector<long> sizes(count);
+		parallel_for(count, tiling.threads, [&](std::size_t i)
+		{
+			helix h = people[i].get().chromosome(chromosome);
+			bounds[i] = find_telomeres(h);
+			sizes[i] = h.size();
+		});
+
+		std::vector<detail::pair_tile> tiles(count);
+		std::vector<std::unique_ptr<lane>> lanes(count * (count - 1) / 2);
+		parallel_for(count, tiling.threads, [&](std::size_t i)
+		{
+			for (auto j = i + 1; j < count; ++j)
+			{
+				const P& lhs = people[i].get();
+				const P& rhs = people[j].get();
+				if (chromosome == sex_chromosome_index && !same_sex_chromosome(lhs, rhs))
+					continue;
+
+				view lhs_view(lhs, chromosome, tiles[i], sizes[i]);
+				view rhs_view(rhs, chromosome, tiles[j], sizes[j]);
+				auto frame = frame_helices(lhs_view, bounds[i], rhs_view, bounds[j]);
+				lanes[detail::pair_index(i, j, count)] = std::make_unique<lane>(lhs_view, rhs_view, chromosome, frame);
+			}
+		});
+
+		std::size_t extent = 0;
+		for (const auto& b : bounds)
+			extent = std::max(extent, b.tail_begin > b.head_end ? b.tail_begin - b.head_end : 0);
+
+		for (std::size_t range = 0; range < extent; range += tiling.range_bases)
+		{
+			parallel_for(count, tiling.threads, [&](std::size_t k)
+			{
+				auto start = bounds[k].head_end + range;
+				auto origin = start > tiling.margin_bases ? start - tiling.margin_bases : 0;
+				origin -= origin % packed_size::value;
+				helix h = people[k].get().chromosome(chromosome);
+				tiles[k] = detail::pair_tile{
+						load_packed(h, origin, start + tiling.range_bases + tiling.margin_bases - origin), origin};
+			});
+
+			parallel_for(block_pairs.size(), tiling.threads, [&](std::size_t k)
+			{
+				auto [lhs_block, rhs_block] = block_pairs[k];
+				auto lhs_first = lhs_block * tiling.block_people;
+				auto rhs_first = rhs_block * tiling.block_people;
+				for (auto i = lhs_first; i < std::min(count, lhs_first + tiling.block_people); ++i)
+				{
+					for (auto j = std::max(i + 1, rhs_first); j < std::min(count, rhs_first + tiling.block_people); ++j)
+					{
+						auto& pair_lane = lanes[detail::pair_index(i, j, count)];
+						if (!pair_lane)
+							continue;
+
+						pair_lane->advance(tiles[i].bases, tiles[i].origin,
+								[&](const difference& found) { emit(i, j, found); },
+								&tiles[j].bases, tiles[j].origin);
+					}
+				}
+			});
+		}
+
+		parallel_for(count, tiling.threads, [&](std::size_t i)
+		{
+			for (auto j = i + 1; j < count; ++j)
+			{
+				if (auto& pair_lane = lanes[detail::pair_index(i, j, count)])
+					pair_lane->finish([&](const difference& found) { emit(i, j, found); });
+			}
+		});
+	}
+}
+
+}
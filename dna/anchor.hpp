@@ -0,0 +1,87 @@
+#pragma once
+
+#include <optional>
+#include <unordered_map>
+#include "kernel.hpp"
+#include "telomere.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t anchor_window_bases = std::size_t{1} << 18;
+static constexpr std::size_t anchor_stride = 61;
+static constexpr std::size_t min_anchor_support = 4;
+
+// rhs position = lhs position + offset, backed by `support` matching seeds.
+struct anchor_offset
+{
+	long offset;
+	std::size_t support;
+};
+
+// Exact 32-mer lookup over a window. K-mers seen more than once are kept but
+// flagged so repeats never vote.
+class kmer_index
+{
+	static constexpr std::size_t ambiguous = ~std::size_t{0};
+
+	std::unordered_map<packed_word, std::size_t> positions_;
+public:
+	kmer_index(const packed_sequence& window, std::size_t origin)
+	{
+		if (window.size() < word_bases)
+			return;
+
+		auto count = window.size() - word_bases + 1;
+		positions_.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			auto inserted = positions_.emplace(window.word(i), origin + i);
+			if (!inserted.second)
+				inserted.first->second = ambiguous;
+		}
+	}
+
+	std::optional<std::size_t> find(packed_word kmer) const
+	{
+		auto found = positions_.find(kmer);
+		if (found == positions_.end() || found->second == ambiguous)
+			return std::nullopt;
+		return found->second;
+	}
+};
+
+// Samples seeds every `stride` bases of `lhs`, looks each one up in an index
+// of `rhs` and returns the offset most seeds agree on.
+inline std::optional<anchor_offset> find_anchor_offset(const packed_sequence& lhs, std::size_t lhs_origin,
+		const kmer_index& rhs, std::size_t stride = anchor_stride)
+{
+	std::unordered_map<long, std::size_t> votes;
+	for (std::size_t i = 0; i + word_bases <= lhs.size(); i += stride)
+	{
+		if (auto position = rhs.find(lhs.word(i)))
+			++votes[static_cast<long>(*position) - static_cast<long>(lhs_origin + i)];
+	}
+
+	std::optional<anchor_offset> best;
+	for (const auto& vote : votes)
+	{
+		if (vote.second >= min_anchor_support && (!best || vote.second > best->support))
+			best = anchor_offset{vote.first, vote.second};
+	}
+	return best;
+}
+
+// Seeds both helices right after their head telomeres, so only
+// `window` bases of each side are ever read.
+template<HelixStream S>
+std::optional<anchor_offset> find_anchor_offset(S& lhs, std::size_t lhs_begin, S& rhs, std::size_t rhs_begin,
+		std::size_t window = anchor_window_bases)
+{
+	auto lhs_window = load_packed(lhs, lhs_begin, window);
+	auto rhs_window = load_packed(rhs, rhs_begin, window);
+
+	return find_anchor_offset(lhs_window, lhs_begin, kmer_index(rhs_window, rhs_begin));
+}
+
+}
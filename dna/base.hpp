@@ -37,7 +37,7 @@ constexpr char to_char(base value)
 
 constexpr std::byte complement_packed(std::byte packed)
 {
-	return packed ^ static_cast<std::byte>(0);
+	return packed ^ static_cast<std::byte>(0xff);
 }
 
 constexpr base complement(enum base base)
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace dna
+{
+
+// Fixed width little-endian fields for the on-disk formats.
+template<typename T>
+void write_le(std::ostream& os, T value)
+{
+	char bytes[sizeof(T)];
+	for (std::size_t i = 0; i < sizeof(T); ++i)
+		bytes[i] = static_cast<char>((static_cast<std::uint64_t>(value) >> (8 * i)) & 0xff);
+	os.write(bytes, sizeof(T));
+}
+
+template<typename T>
+T decode_le(const unsigned char* bytes) noexcept
+{
+	std::uint64_t value = 0;
+	for (std::size_t i = 0; i < sizeof(T); ++i)
+		value |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+	return static_cast<T>(value);
+}
+
+template<typename T>
+T read_le(std::istream& is)
+{
+	unsigned char bytes[sizeof(T)];
+	if (!is.read(reinterpret_cast<char*>(bytes), sizeof(T)))
+		throw std::runtime_error("unexpected end of file");
+	return decode_le<T>(bytes);
+}
+
+// LEB128 varints, with zigzag for signed deltas.
+inline void append_varint(std::string& out, std::uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+inline std::uint64_t decode_varint(const unsigned char*& bytes) noexcept
+{
+	std::uint64_t value = 0;
+	for (unsigned shift = 0;; shift += 7)
+	{
+		auto byte = *bytes++;
+		value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return value;
+	}
+}
+
+constexpr std::uint64_t zigzag(std::int64_t value) noexcept
+{
+	return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+constexpr std::int64_t unzigzag(std::uint64_t value) noexcept
+{
+	return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+#include "alignment_map.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t digest_block_bases = std::size_t{1} << 12;
+static constexpr std::size_t max_dirty_bases = std::size_t{1} << 20;
+static constexpr std::size_t scan_chunk_bases = std::size_t{1} << 20;
+
+// One block of a helix and the digest of its bases.
+struct digest_block
+{
+	std::size_t first;
+	std::size_t count;
+	std::uint64_t digest;
+};
+
+// A source of block digests for one helix. block_at(position) returns the
+// block holding `position`, or nothing past the end of the helix.
+template<typename T>
+concept BlockDigests = requires(T a) {
+	{ a.block_at(std::size_t{0}) } -> std::convertible_to<std::optional<digest_block>>;
+};
+
+// Four independent lanes so the loop has no single dependency chain.
+inline std::uint64_t block_digest(const packed_sequence& bases) noexcept
+{
+	constexpr std::uint64_t multiplier = 0x9e3779b97f4a7c15ull;
+	std::uint64_t lanes[4] = {0x243f6a8885a308d3ull, 0x13198a2e03707344ull, 0xa4093822299f31d0ull, 0x082efa98ec4e6c89ull};
+
+	std::size_t index = 0;
+	for (std::size_t i = 0; i < bases.size(); i += word_bases, ++index)
+		lanes[index % 4] = (lanes[index % 4] ^ bases.word(i)) * multiplier;
+
+	std::uint64_t result = bases.size();
+	for (auto lane : lanes)
+		result = (result ^ (lane >> 29) ^ lane) * multiplier;
+	return result ^ (result >> 32);
+}
+
+namespace detail
+{
+
+constexpr std::uint64_t boundary_hash(packed_word last) noexcept
+{
+	auto hash = (last ^ 0x243f6a8885a308d3ull) * 0x9e3779b97f4a7c15ull;
+	return hash ^ (hash >> 29);
+}
+
+}
+
+// A block as the scanner cut it, with its bases.
+struct scanned_block
+{
+	std::size_t first;
+	packed_sequence bases;
+};
+
+// Streams a helix once and cuts it at content-defined boundaries: a block
+// ends after a base where the hash of the last 32 bases falls under a
+// threshold, once it holds a quarter of `block_bases`, and at four times
+// `block_bases` at most, so blocks average `block_bases`. A cut only depends
+// on the bases around it and on the previous cut, so after an indel both
+// sides fall back onto the same cuts within a block or two and their digests
+// line up again wherever the bases do. With a reference S it reads the
+// caller's helix.
+template<HelixStream S>
+class block_scanner
+{
+	S helix_;
+	std::size_t size_;
+	std::size_t min_;
+	std::size_t max_;
+	std::uint64_t threshold_;
+	packed_sequence chunk_;
+	std::size_t chunk_first_;
+	std::size_t next_;
+	packed_word last_;
+	scanned_block open_;
+
+	scanned_block take()
+	{
+		auto result = std::move(open_);
+		open_ = scanned_block{next_, packed_sequence()};
+		return result;
+	}
+public:
+	block_scanner(S helix, std::size_t block_bases = digest_block_bases) :
+			helix_(std::forward<S>(helix)),
+			size_(helix_size(helix_)),
+			min_(std::max<std::size_t>(word_bases, block_bases / 4)),
+			max_(std::max<std::size_t>(word_bases, 4 * block_bases)),
+			threshold_(~std::uint64_t{0} / std::max<std::size_t>(1, block_bases - std::min(block_bases, min_))),
+			chunk_(),
+			chunk_first_(0),
+			next_(0),
+			last_(0),
+			open_{0, packed_sequence()}
+	{ }
+
+	// The next block; nothing once the helix is done.
+	std::optional<scanned_block> next()
+	{
+		while (next_ < size_)
+		{
+			if (next_ >= chunk_first_ + chunk_.size())
+			{
+				chunk_ = load_packed(helix_, next_, scan_chunk_bases);
+				chunk_first_ = next_;
+				if (chunk_.size() == 0)
+					break;
+			}
+
+			auto value = chunk_[next_ - chunk_first_];
+			last_ = last_ << 2 | static_cast<packed_word>(value);
+			open_.bases.push_back(value);
+			++next_;
+
+			auto length = open_.bases.size();
+			if (length >= max_ || (length >= min_ && detail::boundary_hash(last_) < threshold_))
+				return take();
+		}
+
+		if (open_.bases.size() == 0)
+			return std::nullopt;
+		return take();
+	}
+};
+
+// Cuts and hashes blocks straight from the helix, for people without stored
+// digests. The helix is read once, front to back, as far as requests go.
+template<HelixStream S>
+class computed_digests
+{
+	block_scanner<S> scanner_;
+	std::vector<digest_block> blocks_;
+	bool done_;
+public:
+	explicit computed_digests(S helix, std::size_t block_bases = digest_block_bases) :
+			scanner_(std::move(helix), block_bases),
+			blocks_(),
+			done_(false)
+	{ }
+
+	std::optional<digest_block> block_at(std::size_t position)
+	{
+		while (!done_ && (blocks_.empty() || blocks_.back().first + blocks_.back().count <= position))
+		{
+			if (auto next = scanner_.next())
+				blocks_.push_back(digest_block{next->first, next->bases.size(), block_digest(next->bases)});
+			else
+				done_ = true;
+		}
+
+		auto found = std::upper_bound(blocks_.begin(), blocks_.end(), position,
+				[](std::size_t wanted, const digest_block& block) { return wanted < block.first; });
+		if (found == blocks_.begin() || position >= std::prev(found)->first + std::prev(found)->count)
+			return std::nullopt;
+		return *std::prev(found);
+	}
+};
+
+// Two phase compare: lhs blocks whose digest matches the rhs block starting
+// at the same place under the current offset are skipped, runs of blocks
+// that don't are mapped and compared base by base. The offset left by each
+// run carries over to the blocks after it. While a run grows, a block that
+// still disagrees is also tried under the offset a resync finds there, so
+// the run ends right after an indel instead of dragging on to
+// `max_dirty_bases`. Blocks are cut by content, so both sides' blocks line
+// up again right after an indel of any length and the rest of the
+// chromosome is skipped on digests alone.
+template<HelixStream S, BlockDigests L, BlockDigests R, typename F>
+void compare_coarse(S& lhs, S& rhs, L& lhs_digests, R& rhs_digests, std::size_t chromosome,
+		const alignment_frame& frame, F&& emit)
+{
+	auto offset = frame.offset();
+	auto clean = [&](const digest_block& left, long at)
+	{
+		auto other = static_cast<long>(left.first) + at;
+		if (other < 0)
+			return false;
+
+		auto right = rhs_digests.block_at(static_cast<std::size_t>(other));
+		return right && right->first == static_cast<std::size_t>(other) && right->count == left.count &&
+				right->digest == left.digest;
+	};
+	auto after = [&](const digest_block& block) { return lhs_digests.block_at(block.first + block.count); };
+
+	auto position = frame.lhs_begin;
+	while (position < frame.lhs_end)
+	{
+		auto block = lhs_digests.block_at(position);
+		if (block && clean(*block, offset))
+		{
+			position = block->first + block->count;
+			continue;
+		}
+
+		// A resync that found nothing is only retried once the run has grown
+		// by a search width, so a truly divergent stretch isn't re-seeded
+		// block after block.
+		auto probe = offset;
+		std::optional<std::size_t> failed;
+		auto next = block ? after(*block) : std::nullopt;
+		while (next && next->first < frame.lhs_end && next->first - position < max_dirty_bases && !clean(*next, probe))
+		{
+			if (!failed || next->first - *failed >= resync_search_bases)
+			{
+				auto moved = detail::resync_offset(lhs, rhs, next->first, probe, frame.rhs_end);
+				if (moved)
+				{
+					probe = *moved;
+					failed.reset();
+					if (clean(*next, probe))
+						break;
+				}
+				else
+					failed = next->first;
+			}
+			next = after(*next);
+		}
+
+		auto end = next ? std::min(next->first, frame.lhs_end) : frame.lhs_end;
+		auto other = static_cast<std::size_t>(std::max(0L, static_cast<long>(position) + offset));
+		if (other >= frame.rhs_end)
+			break;
+
+		auto map = map_alignment(lhs, rhs, alignment_frame{position, other, end, frame.rhs_end});
+		compare_mapped(lhs, rhs, chromosome, map, emit);
+		if (!map.empty())
+			offset = static_cast<long>(map.back().rhs) - static_cast<long>(map.back().lhs);
+		position = end;
+	}
+}
+
+template<HelixStream S, typename F>
+void compare_coarse(S& lhs, S& rhs, std::size_t chromosome, const alignment_frame& frame, F&& emit,
+		std::size_t block_bases = digest_block_bases)
+{
+	computed_digests<S> lhs_digests(lhs, block_bases);
+	computed_digests<S> rhs_digests(rhs, block_bases);
+	compare_coarse(lhs, rhs, lhs_digests, rhs_digests, chromosome, frame, emit);
+}
+
+}
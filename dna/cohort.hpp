@@ -0,0 +1,227 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include "alignment_map.hpp"
+#include "engine.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t shared_chunk_bases = std::size_t{1} << 18;
+
+namespace detail
+{
+
+// One target chromosome compared against chunks of the shared query as they
+// go by. It keeps its own offset and resyncs on indels the same way
+// map_alignment() does, but without a separate pass over the query. Target
+// bases are taken from a caller's chunk when it covers them, and read from
+// the target helix otherwise. With a reference S the lane borrows the
+// caller's helices instead of holding its own copies.
+template<HelixStream S>
+class lockstep_target
+{
+	S query_;
+	S helix_;
+	std::size_t chromosome_;
+	alignment_frame frame_;
+	long offset_;
+	std::size_t segment_;
+	std::size_t next_;
+	std::optional<std::size_t> last_resync_;
+	indel_refiner<S> refiner_;
+public:
+	lockstep_target(S query, S helix, std::size_t chromosome, const alignment_frame& frame) :
+			query_(std::forward<S>(query)),
+			helix_(std::forward<S>(helix)),
+			chromosome_(chromosome),
+			frame_(frame),
+			offset_(frame_.offset()),
+			segment_(frame_.lhs_begin),
+			next_(frame_.lhs_begin),
+			last_resync_(),
+			refiner_(query_, helix_)
+	{ }
+
+	lockstep_target(S query, S helix, std::size_t chromosome) :
+			lockstep_target(query, helix, chromosome, frame_helices(query, helix))
+	{ }
+
+	lockstep_target(const lockstep_target&) = delete;
+	lockstep_target& operator=(const lockstep_target&) = delete;
+
+	std::size_t begin() const noexcept
+	{
+		return frame_.lhs_begin;
+	}
+
+	const alignment_frame& frame() const noexcept
+	{
+		return frame_;
+	}
+
+	// The offset the lane has reached so far.
+	long offset() const noexcept
+	{
+		return offset_;
+	}
+
+	// `chunk` holds the query bases from `origin` on, `cached` (if any) the
+	// target bases from `cached_origin` on.
+	template<typename F>
+	void advance(const packed_sequence& chunk, std::size_t origin, F&& emit,
+			const packed_sequence* cached = nullptr, std::size_t cached_origin = 0)
+	{
+		auto refined = [&](const difference& found) { refiner_.push(found, emit); };
+
+		while (true)
+		{
+			auto limit = std::min(frame_.lhs_end, rhs_limit());
+			auto from = std::max(next_, origin);
+			auto to = std::min(origin + chunk.size(), limit);
+			if (from >= to)
+				return;
+
+			auto target_from = static_cast<std::size_t>(static_cast<long>(from) + offset_);
+			auto count = to - from;
+
+			packed_sequence loaded;
+			const packed_sequence* window = cached;
+			std::size_t window_pos = target_from - cached_origin;
+			if (cached == nullptr || target_from < cached_origin || window_pos + count > cached->size())
+			{
+				loaded = load_packed(helix_, target_from, count);
+				window = &loaded;
+				window_pos = 0;
+				count = loaded.size();
+			}
+
+			if (count == 0)
+			{
+				next_ = limit;
+				return;
+			}
+
+			auto scan = scan_sync(chunk, from - origin, *window, window_pos, count);
+			if (!scan.lost)
+			{
+				auto upto = to == limit ? count : scan.position;
+				compare_window(chunk, from - origin, *window, window_pos, chromosome_, range_at(from, upto), refined);
+				next_ = from + upto;
+				return;
+			}
+
+			auto lost = from + scan.position;
+			auto next = last_resync_ && lost <= *last_resync_ ? std::nullopt :
+					resync_offset(query_, helix_, lost, offset_, frame_.rhs_end);
+			if (!next)
+			{
+				auto upto = std::min(scan.position + 2 * word_bases, count);
+				compare_window(chunk, from - origin, *window, window_pos, chromosome_, range_at(from, upto), refined);
+				next_ = from + upto;
+				continue;
+			}
+
+			auto split = refine_breakpoint(query_, helix_, from, lost, offset_, *next);
+			split = normalize_breakpoint(query_, helix_, segment_, split, offset_, *next);
+			if (split > from)
+				compare_window(chunk, from - origin, *window, window_pos, chromosome_, range_at(from, split - from), refined);
+
+			auto resume = split + static_cast<std::size_t>(std::max(0L, offset_ - *next));
+			aligned_range before{segment_, static_cast<std::size_t>(static_cast<long>(segment_) + offset_), split - segment_};
+			aligned_range after{resume, static_cast<std::size_t>(static_cast<long>(resume) + *next), 0};
+			compare_gap(query_, helix_, chromosome_, before, after, refined);
+
+			last_resync_ = lost;
+			segment_ = resume;
+			next_ = std::max(resume, from);
+			offset_ = *next;
+		}
+	}
+
+	template<typename F>
+	void finish(F&& emit)
+	{
+		refiner_.flush(emit);
+	}
+
+private:
+	std::size_t rhs_limit() const noexcept
+	{
+		return static_cast<std::size_t>(std::max(0L, static_cast<long>(frame_.rhs_end) - offset_));
+	}
+
+	aligned_range range_at(std::size_t from, std::size_t length) const noexcept
+	{
+		return aligned_range{from, static_cast<std::size_t>(static_cast<long>(from) + offset_), length};
+	}
+};
+
+}
+
+// Compares one person against many. Each query chromosome is streamed once
+// in chunks small enough to stay in L2, and every chunk is compared against
+// all the targets before the next one is read: one-vs-K reads K + 1 genomes
+// instead of 2K. Results are indexed like `targets`.
+template<Person P>
+std::vector<std::vector<difference>> compare_one_to_many(const P& query,
+		const std::vector<std::reference_wrapper<const P>>& targets, std::size_t threads = default_threads(),
+		std::size_t chunk_bases = shared_chunk_bases)
+{
+	using helix = helix_of<P>;
+
+	std::vector<std::vector<std::vector<difference>>> found(query.chromosomes());
+	parallel_for(query.chromosomes(), threads, [&](std::size_t chromosome)
+	{
+		auto& per_target = found[chromosome];
+		per_target.resize(targets.size());
+
+		helix query_helix = query.chromosome(chromosome);
+		std::deque<detail::lockstep_target<helix>> lanes;
+		std::vector<std::size_t> owners;
+		for (std::size_t i = 0; i < targets.size(); ++i)
+		{
+			const P& target = targets[i].get();
+			if (target.chromosomes() != query.chromosomes())
+				throw std::invalid_argument("people do not have the same number of chromosomes");
+			if (chromosome == sex_chromosome_index && !same_sex_chromosome(query, target))
+				continue;
+
+			lanes.emplace_back(query_helix, target.chromosome(chromosome), chromosome);
+			owners.push_back(i);
+		}
+		if (lanes.empty())
+			return;
+
+		auto begin = lanes.front().begin();
+		for (const auto& lane : lanes)
+			begin = std::min(begin, lane.begin());
+
+		// Each chunk repeats the last two words of the previous one, so a lane
+		// that stopped on a suspicious word can pick up from there.
+		constexpr auto lead = 2 * word_bases;
+		auto end = helix_size(query_helix);
+		for (auto position = begin; position < end; position += chunk_bases)
+		{
+			auto origin = position > begin + lead ? position - lead : begin;
+			auto chunk = load_packed(query_helix, origin, position + chunk_bases - origin);
+
+			for (std::size_t i = 0; i < lanes.size(); ++i)
+				lanes[i].advance(chunk, origin, [&](const difference& d) { per_target[owners[i]].push_back(d); });
+		}
+
+		for (std::size_t i = 0; i < lanes.size(); ++i)
+			lanes[i].finish([&](const difference& d) { per_target[owners[i]].push_back(d); });
+	});
+
+	std::vector<std::vector<difference>> result(targets.size());
+	for (auto& per_target : found)
+	{
+		for (std::size_t i = 0; i < per_target.size(); ++i)
+			result[i].insert(result[i].end(), per_target[i].begin(), per_target[i].end());
+	}
+	return result;
+}
+
+}
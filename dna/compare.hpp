@@ -0,0 +1,125 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+#include "difference.hpp"
+#include "kernel.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t default_chunk_bases = std::size_t{1} << 20;
+
+// `length` bases of two helices that line up, starting at `lhs` and `rhs`.
+struct aligned_range
+{
+	std::size_t lhs;
+	std::size_t rhs;
+	std::size_t length;
+};
+
+constexpr bool operator==(const aligned_range& lhs, const aligned_range& rhs) noexcept
+{
+	return lhs.lhs == rhs.lhs && lhs.rhs == rhs.rhs && lhs.length == rhs.length;
+}
+
+constexpr bool operator!=(const aligned_range& lhs, const aligned_range& rhs) noexcept
+{
+	return !(lhs == rhs);
+}
+
+template<HelixStream S>
+constexpr aligned_range full_range(const S& lhs, const S& rhs)
+{
+	return aligned_range{0, 0, std::min(helix_size(lhs), helix_size(rhs))};
+}
+
+// Holds back the latest difference so runs split over chunk boundaries are
+// reported once.
+class difference_coalescer
+{
+	std::optional<difference> pending_;
+public:
+	template<typename F>
+	void push(const difference& next, F&& emit)
+	{
+		if (pending_ && coalesce(*pending_, next))
+			return;
+		if (pending_)
+			emit(*pending_);
+		pending_ = next;
+	}
+
+	template<typename F>
+	void flush(F&& emit)
+	{
+		if (pending_)
+			emit(*pending_);
+		pending_.reset();
+	}
+};
+
+// Compares range.length bases of two windows already loaded in memory,
+// starting at `lhs_pos` and `rhs_pos` within them. Differences are reported
+// at the helix positions given by `range`.
+template<typename F>
+void compare_window(const packed_sequence& lhs_window, std::size_t lhs_pos, const packed_sequence& rhs_window,
+		std::size_t rhs_pos, std::size_t chromosome, const aligned_range& range, F&& emit)
+{
+	for_each_mismatch_run(lhs_window, lhs_pos, rhs_window, rhs_pos, range.length,
+			[&](std::size_t offset, std::size_t length)
+			{
+				auto alternate = rhs_window.word(rhs_pos + offset);
+				if (length < word_bases)
+					alternate &= ~packed_word{0} << (64 - 2 * length);
+
+				emit(difference{chromosome, range.lhs + offset, length, range.rhs + offset,
+						difference_kind::substitution, alternate});
+			});
+}
+
+// `lhs_chunk` starts at range.lhs and `rhs_chunk` at range.rhs.
+template<typename F>
+void compare_chunk(const packed_sequence& lhs_chunk, const packed_sequence& rhs_chunk,
+		std::size_t chromosome, const aligned_range& range, F&& emit)
+{
+	compare_window(lhs_chunk, 0, rhs_chunk, 0, chromosome, range, std::forward<F>(emit));
+}
+
+// Streams both helices through the XOR kernel one chunk at a time.
+template<HelixStream S, typename F>
+void compare_range(S& lhs, S& rhs, std::size_t chromosome, const aligned_range& range, F&& emit,
+		std::size_t chunk_bases = default_chunk_bases)
+{
+	difference_coalescer pending;
+	for (std::size_t done = 0; done < range.length; done += chunk_bases)
+	{
+		aligned_range chunk{range.lhs + done, range.rhs + done, std::min(chunk_bases, range.length - done)};
+		auto lhs_chunk = load_packed(lhs, chunk.lhs, chunk.length);
+		auto rhs_chunk = load_packed(rhs, chunk.rhs, chunk.length);
+		chunk.length = std::min(lhs_chunk.size(), rhs_chunk.size());
+
+		compare_chunk(lhs_chunk, rhs_chunk, chromosome, chunk,
+				[&](const difference& found) { pending.push(found, emit); });
+	}
+	pending.flush(emit);
+}
+
+template<HelixStream S, typename F>
+void compare_helices(S lhs, S rhs, std::size_t chromosome, const aligned_range& range, F&& emit,
+		std::size_t chunk_bases = default_chunk_bases)
+{
+	compare_range(lhs, rhs, chromosome, range, std::forward<F>(emit), chunk_bases);
+}
+
+template<HelixStream S>
+std::vector<difference> collect_differences(S lhs, S rhs, std::size_t chromosome, const aligned_range& range,
+		std::size_t chunk_bases = default_chunk_bases)
+{
+	std::vector<difference> result;
+	compare_helices(std::move(lhs), std::move(rhs), chromosome, range,
+			[&](const difference& found) { result.push_back(found); }, chunk_bases);
+	return result;
+}
+
+}
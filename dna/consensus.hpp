@@ -0,0 +1,228 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include "alignment_map.hpp"
+#include "kernel.hpp"
+#include "region.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t consensus_shard_bases = std::size_t{1} << 20;
+
+// Per-base vote over `words` word positions across many people, kept as
+// bit-sliced vertical counters: plane j of base b holds bit j of every
+// position's count for b, so one add updates all 32 positions of a word at
+// once. A shard needs log2(voters) planes per base and word, however many
+// people vote.
+class base_vote
+{
+	std::vector<packed_word> planes_;
+	std::size_t depth_;
+
+	packed_word* counter(std::size_t at, std::size_t value) noexcept
+	{
+		return planes_.data() + (4 * at + value) * depth_;
+	}
+
+	void add(packed_word* planes, packed_word carry) noexcept
+	{
+		for (std::size_t j = 0; j < depth_ && carry != 0; ++j)
+		{
+			auto next = planes[j] & carry;
+			planes[j] ^= carry;
+			carry = next;
+		}
+	}
+
+	void tally(packed_word word, packed_word valid, std::size_t at) noexcept
+	{
+		auto high = (word >> 1) & low_bits;
+		auto low = word & low_bits;
+		add(counter(at, 0), ~high & ~low & valid);
+		add(counter(at, 1), ~high & low & valid);
+		add(counter(at, 2), high & ~low & valid);
+		add(counter(at, 3), high & low & valid);
+	}
+
+	// Positions where counter x beats counter y.
+	packed_word greater(const packed_word* x, const packed_word* y) const noexcept
+	{
+		packed_word above = 0;
+		packed_word equal = low_bits;
+		for (auto j = depth_; j-- > 0;)
+		{
+			above |= equal & x[j] & ~y[j];
+			equal &= ~(x[j] ^ y[j]);
+		}
+		return above;
+	}
+public:
+	explicit base_vote(std::size_t voters, std::size_t words = 1) :
+			planes_(),
+			depth_(1)
+	{
+		while ((std::size_t{1} << depth_) <= voters)
+			++depth_;
+		planes_.assign(4 * depth_ * words, 0);
+	}
+
+	void clear() noexcept
+	{
+		std::fill(planes_.begin(), planes_.end(), 0);
+	}
+
+	// Counts the first `bases` bases of a word at word position `at`.
+	void add(packed_word word, std::size_t bases, std::size_t at = 0) noexcept
+	{
+		tally(word, lead_mask(bases), at);
+	}
+
+	// Counts a run of bases laid from base `first` of the shard on, which
+	// needn't start a word.
+	void add(const packed_sequence& bases, std::size_t first) noexcept
+	{
+		for (std::size_t i = 0; i < bases.size();)
+		{
+			auto slot = (first + i) % word_bases;
+			auto count = std::min(word_bases - slot, bases.size() - i);
+			tally(bases.word(i) >> (2 * slot), lead_mask(slot + count) & ~lead_mask(slot), (first + i) / word_bases);
+			i += count;
+		}
+	}
+
+	// The most voted base at every position of word `at`, ties going to the
+	// lower base. A size_t count never needs more than 64 planes.
+	packed_word winner(std::size_t at = 0) const noexcept
+	{
+		std::array<packed_word, 64> best;
+		std::copy_n(planes_.begin() + static_cast<long>(4 * at * depth_), depth_, best.begin());
+		packed_word code = 0;
+		for (std::size_t value = 1; value < 4; ++value)
+		{
+			const auto* challenger = planes_.data() + (4 * at + value) * depth_;
+			auto wins = greater(challenger, best.data());
+			for (std::size_t j = 0; j < depth_; ++j)
+				best[j] = (challenger[j] & wins) | (best[j] & ~wins);
+
+			auto bits = static_cast<packed_word>(value) * low_bits;
+			code = (code & ~(wins | wins << 1)) | (bits & (wins | wins << 1));
+		}
+		return code;
+	}
+};
+
+namespace detail
+{
+
+template<Person P>
+std::vector<std::size_t> consensus_voters(const std::vector<std::reference_wrapper<const P>>& people,
+		std::size_t chromosome)
+{
+	std::vector<std::size_t> voters(people.size());
+	for (std::size_t i = 0; i < people.size(); ++i)
+		voters[i] = i;
+	if (chromosome != sex_chromosome_index)
+		return voters;
+
+	std::vector<std::size_t> x;
+	std::vector<std::size_t> y;
+	for (auto i : voters)
+		(classify_sex_chromosome(people[i].get().chromosome(chromosome)) == sex_chromosome::x ? x : y).push_back(i);
+	return x.size() >= y.size() ? x : y;
+}
+
+}
+
+// Builds a consensus of every chromosome by per-position majority over the
+// people. The first voter whose head telomeres are found is the reference:
+// positions are its bases counted from the end of its head telomeres, and
+// every other voter is aligned to it once per chromosome with map_alignment,
+// so a voter carrying an indel still votes on the bases that line up. A voter
+// with no head telomeres has no origin to align from and sits the chromosome
+// out. Each shard of `shard_bases` reads each voter's aligned pieces of that
+// window one person at a time into the shard's vote, so a worker holds one
+// window and O(shard_bases * log people) counters however large the cohort;
+// emit(chromosome, first, bases) receives the shards in order.
+// Chromosome 23 only takes votes from the more common of X and Y.
+template<Person P, typename F>
+void build_consensus(const std::vector<std::reference_wrapper<const P>>& people, F&& emit,
+		std::size_t threads = default_threads(), std::size_t shard_bases = consensus_shard_bases)
+{
+	if (people.empty())
+		return;
+	shard_bases = std::max(word_bases, shard_bases / word_bases * word_bases);
+
+	for (std::size_t chromosome = 0; chromosome < people.front().get().chromosomes(); ++chromosome)
+	{
+		std::vector<std::size_t> voters;
+		std::vector<std::size_t> origins;
+		std::vector<std::size_t> ends;
+		for (auto i : detail::consensus_voters(people, chromosome))
+		{
+			helix_of<P> helix = people[i].get().chromosome(chromosome);
+			if (auto origin = region_origin(helix))
+			{
+				voters.push_back(i);
+				origins.push_back(*origin);
+				ends.push_back(helix_size(helix));
+			}
+		}
+		if (voters.empty() || ends.front() <= origins.front())
+			continue;
+
+		std::vector<alignment_map> maps(voters.size());
+		maps.front().push_back(aligned_range{origins.front(), origins.front(), ends.front() - origins.front()});
+		parallel_for(voters.size() - 1, threads, [&](std::size_t slot)
+		{
+			auto v = slot + 1;
+			helix_of<P> reference = people[voters.front()].get().chromosome(chromosome);
+			helix_of<P> helix = people[voters[v]].get().chromosome(chromosome);
+			maps[v] = map_alignment(reference, helix, alignment_frame{origins.front(), origins[v], ends.front(), ends[v]});
+		});
+
+		auto length = ends.front() - origins.front();
+		auto shards = (length + shard_bases - 1) / shard_bases;
+		auto batch = std::max<std::size_t>(1, threads);
+		for (std::size_t first_shard = 0; first_shard < shards; first_shard += batch)
+		{
+			auto count = std::min(batch, shards - first_shard);
+			std::vector<packed_sequence> built(count);
+			parallel_for(count, threads, [&](std::size_t slot)
+			{
+				auto first = (first_shard + slot) * shard_bases;
+				auto bases = std::min(shard_bases, length - first);
+				auto from = origins.front() + first;
+				auto to = from + bases;
+
+				auto word_count = (bases + word_bases - 1) / word_bases;
+				base_vote vote(voters.size(), word_count);
+				for (std::size_t v = 0; v < voters.size(); ++v)
+				{
+					helix_of<P> helix = people[voters[v]].get().chromosome(chromosome);
+					const auto& map = maps[v];
+					auto segment = std::partition_point(map.begin(), map.end(),
+							[&](const aligned_range& range) { return range.lhs + range.length <= from; });
+					for (; segment != map.end() && segment->lhs < to; ++segment)
+					{
+						auto lo = std::max(from, segment->lhs);
+						auto hi = std::min(to, segment->lhs + segment->length);
+						vote.add(load_packed(helix, segment->rhs + (lo - segment->lhs), hi - lo), lo - from);
+					}
+				}
+
+				std::vector<packed_word> words;
+				words.reserve(word_count);
+				for (std::size_t w = 0; w < word_count; ++w)
+					words.push_back(vote.winner(w));
+				built[slot] = packed_sequence(std::move(words), bases);
+			});
+
+			for (std::size_t slot = 0; slot < count; ++slot)
+				emit(chromosome, (first_shard + slot) * shard_bases, built[slot]);
+		}
+	}
+}
+
+}
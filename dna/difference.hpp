@@ -0,0 +1,102 @@
+#pragma once
+
+#include <ostream>
+#include "packed_sequence.hpp"
+
+namespace dna
+{
+
+enum class difference_kind : std::uint8_t
+{
+	substitution,
+	insertion,
+	deletion,
+	inversion
+};
+
+// An interval where two helices disagree. `start`/`length` are lhs bases and
+// `other_start` is the matching rhs position. Insertions cover `length` rhs
+// bases placed before `start`; deletions cover lhs bases missing on the rhs;
+// inversions cover lhs bases found reverse complemented at the same place on
+// the rhs. `alternate` holds up to the first 32 rhs bases of substitutions and
+// insertions.
+struct difference
+{
+	std::size_t chromosome;
+	std::size_t start;
+	std::size_t length;
+	std::size_t other_start;
+	difference_kind kind;
+	packed_word alternate;
+
+	constexpr std::size_t end() const noexcept
+	{
+		return start + (kind == difference_kind::insertion ? 0 : length);
+	}
+
+	constexpr std::size_t other_end() const noexcept
+	{
+		return other_start + (kind == difference_kind::deletion ? 0 : length);
+	}
+};
+
+constexpr bool operator==(const difference& lhs, const difference& rhs) noexcept
+{
+	return lhs.chromosome == rhs.chromosome &&
+			lhs.start == rhs.start &&
+			lhs.length == rhs.length &&
+			lhs.other_start == rhs.other_start &&
+			lhs.kind == rhs.kind &&
+			lhs.alternate == rhs.alternate;
+}
+
+constexpr bool operator!=(const difference& lhs, const difference& rhs) noexcept
+{
+	return !(lhs == rhs);
+}
+
+constexpr bool operator<(const difference& lhs, const difference& rhs) noexcept
+{
+	if (lhs.chromosome != rhs.chromosome)
+		return lhs.chromosome < rhs.chromosome;
+	if (lhs.start != rhs.start)
+		return lhs.start < rhs.start;
+	return lhs.other_start < rhs.other_start;
+}
+
+// Joins `next` into `last` when both are substitutions that touch on both
+// helices, as happens when a run straddles two chunks.
+constexpr bool coalesce(difference& last, const difference& next) noexcept
+{
+	if (last.kind != difference_kind::substitution || next.kind != difference_kind::substitution ||
+			last.chromosome != next.chromosome || last.end() != next.start || last.other_end() != next.other_start)
+		return false;
+
+	if (last.length < word_bases)
+		last.alternate |= next.alternate >> (2 * last.length);
+	last.length += next.length;
+	return true;
+}
+
+inline std::ostream& operator<<(std::ostream& os, difference_kind kind)
+{
+	switch (kind)
+	{
+		case difference_kind::insertion:
+			return os << "insertion";
+		case difference_kind::deletion:
+			return os << "deletion";
+		case difference_kind::inversion:
+			return os << "inversion";
+		default:
+			return os << "substitution";
+	}
+}
+
+inline std::ostream& operator<<(std::ostream& os, const difference& value)
+{
+	return os << value.kind << '(' << (value.chromosome + 1) << ':' << value.start << '+' << value.length
+			<< " @" << value.other_start << ')';
+}
+
+}
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <optional>
+#include <ranges>
+#include <string>
+#include "binary_io.hpp"
+#include "difference.hpp"
+#include "mapped_file.hpp"
+
+namespace dna
+{
+
+static constexpr std::array<char, 8> store_magic = {'D', 'N', 'A', 'D', 'I', 'F', '0', '2'};
+static constexpr std::size_t store_block_records = 4096;
+static constexpr std::size_t store_columns = 6;
+static constexpr std::size_t store_entry_bytes = 8 + 4 + 4 + 8 + 4 + 8 + 4 * store_columns;
+static constexpr std::size_t store_footer_bytes = 4 * 8 + store_magic.size();
+
+// Records are kept sorted by chromosome then start and cut into blocks. Each
+// block stores six varint columns one after the other: chromosome delta,
+// zigzag start delta, length, zigzag rhs shift, kind and the alternate bases.
+// The directory after the blocks has one fixed-size entry per block and a
+// footer at the very end points to it.
+//
+// `reach` is the furthest base covered on `last_chromosome` by the records of
+// this block and the blocks before it, an insertion counting as covering the
+// base at its start. Being a running maximum, it never falls within a
+// chromosome, so scans can binary search it.
+struct store_block
+{
+	std::uint64_t offset;
+	std::uint32_t records;
+	std::uint32_t first_chromosome;
+	std::uint64_t first_start;
+	std::uint32_t last_chromosome;
+	std::uint64_t reach;
+	std::array<std::uint32_t, store_columns> columns;
+};
+
+namespace detail
+{
+
+inline std::size_t difference_reach(const difference& found) noexcept
+{
+	return std::max(found.end(), found.start + 1);
+}
+
+inline bool overlaps(const difference& found, std::size_t chromosome, std::size_t from, std::size_t to) noexcept
+{
+	return found.chromosome == chromosome && found.start < to && difference_reach(found) > from;
+}
+
+inline std::uint64_t stored_alternate(const difference& found) noexcept
+{
+	if (found.kind == difference_kind::deletion || found.length == 0)
+		return 0;
+	return found.alternate >> (64 - 2 * std::min(found.length, word_bases));
+}
+
+inline packed_word loaded_alternate(std::uint64_t stored, difference_kind kind, std::size_t length) noexcept
+{
+	if (kind == difference_kind::deletion || length == 0)
+		return 0;
+	return stored << (64 - 2 * std::min(length, word_bases));
+}
+
+}
+
+// Engine sink writing a store. Differences must arrive in store order.
+class difference_store_writer
+{
+	std::ostream& os_;
+	std::size_t block_records_;
+	std::vector<difference> pending_;
+	std::vector<store_block> directory_;
+	std::uint64_t written_;
+	std::uint64_t records_;
+	std::optional<difference> last_;
+	bool finished_;
+
+	void write_block()
+	{
+		if (pending_.empty())
+			return;
+
+		std::array<std::string, store_columns> columns;
+		std::size_t chromosome = 0;
+		std::size_t start = 0;
+		store_block entry{written_, static_cast<std::uint32_t>(pending_.size()),
+				static_cast<std::uint32_t>(pending_.front().chromosome), pending_.front().start,
+				static_cast<std::uint32_t>(pending_.back().chromosome), 0, {}};
+
+		for (const auto& found : pending_)
+		{
+			append_varint(columns[0], found.chromosome - chromosome);
+			append_varint(columns[1], zigzag(static_cast<std::int64_t>(found.start) - static_cast<std::int64_t>(start)));
+			append_varint(columns[2], found.length);
+			append_varint(columns[3], zigzag(static_cast<std::int64_t>(found.other_start) -
+					static_cast<std::int64_t>(found.start)));
+			append_varint(columns[4], static_cast<std::uint64_t>(found.kind));
+			append_varint(columns[5], detail::stored_alternate(found));
+			chromosome = found.chromosome;
+			start = found.start;
+			if (found.chromosome == entry.last_chromosome)
+				entry.reach = std::max<std::uint64_t>(entry.reach, detail::difference_reach(found));
+		}
+		if (!directory_.empty() && directory_.back().last_chromosome == entry.last_chromosome)
+			entry.reach = std::max(entry.reach, directory_.back().reach);
+
+		std::uint32_t offset = 0;
+		for (std::size_t i = 0; i < store_columns; ++i)
+		{
+			entry.columns[i] = offset;
+			os_.write(columns[i].data(), static_cast<std::streamsize>(columns[i].size()));
+			offset += static_cast<std::uint32_t>(columns[i].size());
+		}
+
+		written_ += offset;
+		records_ += pending_.size();
+		directory_.push_back(entry);
+		pending_.clear();
+	}
+public:
+	explicit difference_store_writer(std::ostream& os, std::size_t block_records = store_block_records) :
+			os_(os),
+			block_records_(block_records),
+			pending_(),
+			directory_(),
+			written_(store_magic.size()),
+			records_(0),
+			last_(),
+			finished_(false)
+	{
+		pending_.reserve(block_records_);
+		os_.write(store_magic.data(), store_magic.size());
+	}
+
+	difference_store_writer(const difference_store_writer&) = delete;
+	difference_store_writer& operator=(const difference_store_writer&) = delete;
+
+	void operator()(const difference& found)
+	{
+		if (finished_)
+			throw std::logic_error("difference store already finished");
+		if (last_ && found < *last_)
+			throw std::invalid_argument("differences must be written in order");
+
+		last_ = found;
+		pending_.push_back(found);
+		if (pending_.size() == block_records_)
+			write_block();
+	}
+
+	void finish()
+	{
+		if (finished_)
+			return;
+		write_block();
+
+		auto directory = written_;
+		for (const auto& entry : directory_)
+		{
+			write_le<std::uint64_t>(os_, entry.offset);
+			write_le<std::uint32_t>(os_, entry.records);
+			write_le<std::uint32_t>(os_, entry.first_chromosome);
+			write_le<std::uint64_t>(os_, entry.first_start);
+			write_le<std::uint32_t>(os_, entry.last_chromosome);
+			write_le<std::uint64_t>(os_, entry.reach);
+			for (auto column : entry.columns)
+				write_le<std::uint32_t>(os_, column);
+		}
+
+		write_le<std::uint64_t>(os_, block_records_);
+		write_le<std::uint64_t>(os_, records_);
+		write_le<std::uint64_t>(os_, directory_.size());
+		write_le<std::uint64_t>(os_, directory);
+		os_.write(store_magic.data(), store_magic.size());
+		finished_ = true;
+	}
+};
+
+inline void write_difference_store(std::vector<difference> found, const std::string& path,
+		std::size_t block_records = store_block_records)
+{
+	std::ofstream os(path, std::ios::binary | std::ios::trunc);
+	if (!os)
+		throw std::runtime_error("unable to create difference store " + path);
+
+	std::sort(found.begin(), found.end());
+	difference_store_writer writer(os, block_records);
+	for (const auto& each : found)
+		writer(each);
+	writer.finish();
+}
+
+// Read-only view of a store through a mapping. Range scans binary search the
+// directory for the first block that can hold a match, then decode blocks
+// until one starts past the range.
+class difference_store
+{
+	mapped_file file_;
+	std::size_t block_records_;
+	std::size_t records_;
+	std::size_t blocks_;
+	const unsigned char* directory_;
+public:
+	explicit difference_store(const std::string& path) :
+			file_(path),
+			block_records_(0),
+			records_(0),
+			blocks_(0),
+			directory_(nullptr)
+	{
+		auto matches = [&](const unsigned char* at)
+		{
+			return std::equal(store_magic.begin(), store_magic.end(), at,
+					[](char expected, unsigned char found) { return static_cast<unsigned char>(expected) == found; });
+		};
+
+		if (file_.size() < store_magic.size() + store_footer_bytes || !matches(file_.data()) ||
+				!matches(file_.data() + file_.size() - store_magic.size()))
+			throw std::runtime_error("not a difference store " + path);
+
+		auto footer = file_.data() + file_.size() - store_footer_bytes;
+		block_records_ = decode_le<std::uint64_t>(footer);
+		records_ = decode_le<std::uint64_t>(footer + 8);
+		blocks_ = decode_le<std::uint64_t>(footer + 16);
+		auto directory = decode_le<std::uint64_t>(footer + 24);
+
+		if (directory + blocks_ * store_entry_bytes + store_footer_bytes != file_.size())
+			throw std::runtime_error("corrupt difference store " + path);
+		directory_ = file_.data() + directory;
+	}
+
+	std::size_t size() const noexcept
+	{
+		return records_;
+	}
+
+	std::size_t blocks() const noexcept
+	{
+		return blocks_;
+	}
+
+	// One past the highest chromosome holding a record.
+	std::size_t chromosomes() const noexcept
+	{
+		return blocks_ == 0 ? 0 : block(blocks_ - 1).last_chromosome + 1;
+	}
+
+	store_block block(std::size_t index) const noexcept
+	{
+		auto entry = directory_ + index * store_entry_bytes;
+		store_block result{decode_le<std::uint64_t>(entry), decode_le<std::uint32_t>(entry + 8),
+				decode_le<std::uint32_t>(entry + 12), decode_le<std::uint64_t>(entry + 16),
+				decode_le<std::uint32_t>(entry + 24), decode_le<std::uint64_t>(entry + 28), {}};
+		for (std::size_t i = 0; i < store_columns; ++i)
+			result.columns[i] = decode_le<std::uint32_t>(entry + 36 + 4 * i);
+		return result;
+	}
+
+	template<typename F>
+	void decode_block(std::size_t index, F&& f) const
+	{
+		auto entry = block(index);
+		std::array<const unsigned char*, store_columns> columns;
+		for (std::size_t i = 0; i < store_columns; ++i)
+			columns[i] = file_.data() + entry.offset + entry.columns[i];
+
+		std::size_t chromosome = 0;
+		std::size_t start = 0;
+		for (std::uint32_t i = 0; i < entry.records; ++i)
+		{
+			chromosome += decode_varint(columns[0]);
+			start = static_cast<std::size_t>(static_cast<std::int64_t>(start) + unzigzag(decode_varint(columns[1])));
+			auto length = decode_varint(columns[2]);
+			auto other = static_cast<std::int64_t>(start) + unzigzag(decode_varint(columns[3]));
+			auto kind = static_cast<difference_kind>(decode_varint(columns[4]));
+			auto alternate = detail::loaded_alternate(decode_varint(columns[5]), kind, length);
+			f(difference{chromosome, start, length, static_cast<std::size_t>(other), kind, alternate});
+		}
+	}
+
+	// Records are numbered in store order; only the block holding it is read.
+	difference record(std::size_t index) const
+	{
+		if (index >= records_)
+			throw std::out_of_range("difference store record out of range");
+
+		std::optional<difference> result;
+		std::size_t slot = 0;
+		decode_block(index / block_records_, [&](const difference& found)
+		{
+			if (slot++ == index % block_records_)
+				result = found;
+		});
+		return *result;
+	}
+
+	template<typename F>
+	void for_each(F&& f) const
+	{
+		for (std::size_t i = 0; i < blocks_; ++i)
+			decode_block(i, f);
+	}
+
+	// The first block that can hold a record on `chromosome`.
+	std::size_t first_block(std::size_t chromosome) const noexcept
+	{
+		std::size_t low = 0;
+		std::size_t high = blocks_;
+		while (low < high)
+		{
+			auto middle = (low + high) / 2;
+			if (block(middle).last_chromosome < chromosome)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		return low;
+	}
+
+	// Calls f for every difference on `chromosome` that overlaps [from, to).
+	// Blocks ending on an earlier chromosome, or on this one short of `from`,
+	// come first in the directory; the scan starts right after them.
+	template<typename F>
+	void scan(std::size_t chromosome, std::size_t from, std::size_t to, F&& f) const
+	{
+		auto indexes = std::views::iota(std::size_t{0}, blocks_);
+		auto first = std::ranges::partition_point(indexes, [&](std::size_t i)
+		{
+			auto entry = block(i);
+			return entry.last_chromosome < chromosome || (entry.last_chromosome == chromosome && entry.reach <= from);
+		});
+
+		for (auto i = static_cast<std::size_t>(first - indexes.begin()); i < blocks_; ++i)
+		{
+			auto entry = block(i);
+			if (entry.first_chromosome > chromosome || (entry.first_chromosome == chromosome && entry.first_start >= to))
+				break;
+
+			decode_block(i, [&](const difference& found)
+			{
+				if (detail::overlaps(found, chromosome, from, to))
+					f(found);
+			});
+		}
+	}
+};
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdexcept>
+#include <type_traits>
+#include "alignment_map.hpp"
+#include "parallel.hpp"
+#include "sex_chromosome.hpp"
+
+namespace dna
+{
+
+template<Person P>
+using helix_of = std::remove_cv_t<std::remove_reference_t<decltype(std::declval<const P&>().chromosome(0))>>;
+
+// Chromosomes worth comparing between two people: all of them, except the
+// sex chromosome when one sample carries an X and the other a Y. That check
+// only looks at sizes so a skipped chromosome costs no I/O.
+template<Person P>
+std::vector<std::size_t> comparable_chromosomes(const P& lhs, const P& rhs)
+{
+	if (lhs.chromosomes() != rhs.chromosomes())
+		throw std::invalid_argument("people do not have the same number of chromosomes");
+
+	std::vector<std::size_t> result;
+	for (std::size_t i = 0; i < lhs.chromosomes(); ++i)
+	{
+		if (i != sex_chromosome_index || same_sex_chromosome(lhs, rhs))
+			result.push_back(i);
+	}
+	return result;
+}
+
+template<Person P>
+std::vector<difference> compare_chromosome(const P& lhs, const P& rhs, std::size_t chromosome,
+		std::size_t chunk_bases = default_chunk_bases)
+{
+	helix_of<P> lhs_helix = lhs.chromosome(chromosome);
+	helix_of<P> rhs_helix = rhs.chromosome(chromosome);
+	auto frame = frame_helices(lhs_helix, rhs_helix);
+	auto map = map_alignment(lhs_helix, rhs_helix, frame);
+
+	std::vector<difference> result;
+	compare_mapped(lhs_helix, rhs_helix, chromosome, map,
+			[&](const difference& found) { result.push_back(found); }, chunk_bases);
+	return result;
+}
+
+// Compares every comparable chromosome, one task per chromosome. Results are
+// ordered by chromosome then position.
+template<Person P>
+std::vector<difference> compare_people(const P& lhs, const P& rhs, std::size_t threads = default_threads(),
+		std::size_t chunk_bases = default_chunk_bases)
+{
+	auto chromosomes = comparable_chromosomes(lhs, rhs);
+	std::vector<std::vector<difference>> found(chromosomes.size());
+
+	parallel_for(chromosomes.size(), threads, [&](std::size_t i)
+	{
+		found[i] = compare_chromosome(lhs, rhs, chromosomes[i], chunk_bases);
+	});
+
+	std::vector<difference> result;
+	for (auto& part : found)
+		result.insert(result.end(), part.begin(), part.end());
+	return result;
+}
+
+}
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include "difference_store.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+#include "variant.hpp"
+
+namespace dna
+{
+
+static constexpr std::array<char, 8> frequency_magic = {'D', 'N', 'A', 'F', 'R', 'Q', '0', '1'};
+static constexpr std::size_t frequency_bin_bits = 16;
+static constexpr std::size_t frequency_shards = 64;
+static constexpr std::size_t expected_variants = std::size_t{1} << 20;
+
+struct allele_count
+{
+	variant key;
+	std::uint64_t carriers;
+};
+
+struct frequency_table
+{
+	std::uint64_t people;
+	std::vector<allele_count> alleles;
+
+	double frequency(std::size_t index) const noexcept
+	{
+		return people == 0 ? 0.0 : static_cast<double>(alleles[index].carriers) / static_cast<double>(people);
+	}
+};
+
+namespace detail
+{
+
+inline std::uint64_t variant_hash(const variant& key) noexcept
+{
+	auto hash = mix_bits(key.chromosome * 0x9e3779b97f4a7c15ull ^ key.position);
+	hash = mix_bits(hash ^ (key.length << 2 | static_cast<std::uint64_t>(key.kind)));
+	return mix_bits(hash ^ key.alternate);
+}
+
+}
+
+// Open addressing table of allele counters. Counting an allele already in the
+// table is one atomic add; a new allele claims an empty slot with a CAS and
+// publishes it by storing its tag. Adds hold the table's lock shared, so they
+// never wait on each other; past three quarters full, the first add to notice
+// takes it exclusively and doubles the table.
+class allele_counters
+{
+	static constexpr std::uint64_t empty = 0;
+	static constexpr std::uint64_t claimed = 2;
+
+	struct slot
+	{
+		std::atomic<std::uint64_t> tag{empty};
+		variant key{};
+		std::atomic<std::uint64_t> count{0};
+	};
+
+	struct table
+	{
+		std::unique_ptr<slot[]> slots;
+		std::size_t mask;
+		std::size_t limit;
+		std::atomic<std::size_t> used;
+
+		explicit table(std::size_t size) :
+				slots(std::make_unique<slot[]>(size)),
+				mask(size - 1),
+				limit(size / 4 * 3),
+				used(0)
+		{ }
+	};
+
+	std::shared_mutex resize_lock_;
+	std::unique_ptr<table> table_;
+
+	// False once the table is too full to take a new allele.
+	static bool add_slot(table& into, const variant& key, std::uint64_t hash, std::uint64_t count)
+	{
+		auto tag = hash | 1;
+		for (std::size_t probe = 0; probe <= into.mask; ++probe)
+		{
+			auto& current = into.slots[(hash + probe) & into.mask];
+			auto seen = current.tag.load(std::memory_order_acquire);
+
+			if (seen == empty)
+			{
+				if (into.used.load(std::memory_order_relaxed) >= into.limit)
+					return false;
+				if (current.tag.compare_exchange_strong(seen, claimed, std::memory_order_acq_rel))
+				{
+					into.used.fetch_add(1, std::memory_order_relaxed);
+					current.key = key;
+					current.count.store(count, std::memory_order_relaxed);
+					current.tag.store(tag, std::memory_order_release);
+					return true;
+				}
+			}
+
+			while (seen == claimed)
+				seen = current.tag.load(std::memory_order_acquire);
+
+			if (seen == tag && current.key == key)
+			{
+				current.count.fetch_add(count, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void grow(const table* full)
+	{
+		std::unique_lock<std::shared_mutex> guard(resize_lock_);
+		if (table_.get() != full)
+			return;
+
+		auto grown = std::make_unique<table>(2 * (table_->mask + 1));
+		for (std::size_t i = 0; i <= table_->mask; ++i)
+		{
+			const auto& current = table_->slots[i];
+			if (current.tag.load(std::memory_order_relaxed) != empty)
+				add_slot(*grown, current.key, detail::variant_hash(current.key), current.count.load(std::memory_order_relaxed));
+		}
+		table_ = std::move(grown);
+	}
+public:
+	explicit allele_counters(std::size_t capacity) :
+			resize_lock_(),
+			table_()
+	{
+		std::size_t size = 16;
+		while (size < capacity + capacity / 3)
+			size <<= 1;
+		table_ = std::make_unique<table>(size);
+	}
+
+	void add(const variant& key)
+	{
+		auto hash = detail::variant_hash(key);
+		for (;;)
+		{
+			const table* full = nullptr;
+			{
+				std::shared_lock<std::shared_mutex> guard(resize_lock_);
+				if (add_slot(*table_, key, hash, 1))
+					return;
+				full = table_.get();
+			}
+			grow(full);
+		}
+	}
+
+	// Only once every writer is done.
+	template<typename F>
+	void for_each(F&& f) const
+	{
+		for (std::size_t i = 0; i <= table_->mask; ++i)
+			if (table_->slots[i].tag.load(std::memory_order_acquire) != empty)
+				f(table_->slots[i].key, table_->slots[i].count.load(std::memory_order_relaxed));
+	}
+};
+
+// Counts how many people carry each allele, substitution runs counted per
+// base. People are spread over the workers while alleles go to counter
+// shards picked by genomic bin; `capacity` only sizes the shards to start
+// with, as each grows on its own, so the memory follows the number of
+// distinct alleles, not the cohort size.
+inline frequency_table aggregate_frequencies(const std::vector<std::reference_wrapper<const difference_store>>& people,
+		std::size_t threads = default_threads(), std::size_t capacity = expected_variants,
+		std::size_t shards = frequency_shards)
+{
+	std::vector<std::unique_ptr<allele_counters>> counters;
+	for (std::size_t i = 0; i < shards; ++i)
+		counters.push_back(std::make_unique<allele_counters>(capacity / shards + 1));
+
+	parallel_for(people.size(), threads, [&](std::size_t person)
+	{
+		people[person].get().for_each([&](const difference& found)
+		{
+			for_each_allele(found, [&](const variant& key)
+			{
+				auto bin = mix_bits(key.chromosome << 48 ^ key.position >> frequency_bin_bits);
+				counters[bin % shards]->add(key);
+			});
+		});
+	});
+
+	std::vector<std::vector<allele_count>> merged(shards);
+	parallel_for(shards, threads, [&](std::size_t shard)
+	{
+		auto& alleles = merged[shard];
+		counters[shard]->for_each([&](const variant& key, std::uint64_t count)
+		{
+			alleles.push_back(allele_count{key, count});
+		});
+		std::sort(alleles.begin(), alleles.end(),
+				[](const allele_count& lhs, const allele_count& rhs) { return lhs.key < rhs.key; });
+	});
+
+	// An allele's bin picks its shard, so the shards share no key and a
+	// k-way merge of the sorted shards is the whole table.
+	struct cursor
+	{
+		std::size_t shard;
+		std::size_t next;
+	};
+	auto after = [&](const cursor& lhs, const cursor& rhs)
+	{
+		return merged[rhs.shard][rhs.next].key < merged[lhs.shard][lhs.next].key;
+	};
+
+	std::vector<cursor> heap;
+	std::size_t total = 0;
+	for (std::size_t shard = 0; shard < shards; ++shard)
+	{
+		total += merged[shard].size();
+		if (!merged[shard].empty())
+			heap.push_back(cursor{shard, 0});
+	}
+	std::make_heap(heap.begin(), heap.end(), after);
+
+	frequency_table table{people.size(), {}};
+	table.alleles.reserve(total);
+	while (!heap.empty())
+	{
+		std::pop_heap(heap.begin(), heap.end(), after);
+		auto& top = heap.back();
+		table.alleles.push_back(merged[top.shard][top.next]);
+		if (++top.next < merged[top.shard].size())
+			std::push_heap(heap.begin(), heap.end(), after);
+		else
+			heap.pop_back();
+	}
+	return table;
+}
+
+inline void write_frequency_table(const frequency_table& table, std::ostream& os)
+{
+	os.write(frequency_magic.data(), frequency_magic.size());
+	write_le<std::uint64_t>(os, table.people);
+	write_le<std::uint64_t>(os, table.alleles.size());
+	for (const auto& each : table.alleles)
+	{
+		write_le<std::uint32_t>(os, each.key.chromosome);
+		write_le<std::uint64_t>(os, each.key.position);
+		write_le<std::uint32_t>(os, each.key.length);
+		write_le<std::uint8_t>(os, static_cast<std::uint8_t>(each.key.kind));
+		write_le<std::uint64_t>(os, each.key.alternate);
+		write_le<std::uint64_t>(os, each.carriers);
+	}
+}
+
+inline void write_frequency_table(const frequency_table& table, const std::string& path)
+{
+	std::ofstream os(path, std::ios::binary | std::ios::trunc);
+	if (!os)
+		throw std::runtime_error("unable to create frequency table " + path);
+	write_frequency_table(table, os);
+}
+
+inline frequency_table read_frequency_table(std::istream& is)
+{
+	std::array<char, 8> magic{};
+	is.read(magic.data(), magic.size());
+	if (!is || magic != frequency_magic)
+		throw std::runtime_error("not a frequency table");
+
+	frequency_table table{read_le<std::uint64_t>(is), {}};
+	auto count = read_le<std::uint64_t>(is);
+	table.alleles.reserve(count);
+	for (std::uint64_t i = 0; i < count; ++i)
+	{
+		variant key{};
+		key.chromosome = read_le<std::uint32_t>(is);
+		key.position = read_le<std::uint64_t>(is);
+		key.length = read_le<std::uint32_t>(is);
+		key.kind = static_cast<difference_kind>(read_le<std::uint8_t>(is));
+		key.alternate = read_le<std::uint64_t>(is);
+		table.alleles.push_back(allele_count{key, read_le<std::uint64_t>(is)});
+	}
+	return table;
+}
+
+inline frequency_table read_frequency_table(const std::string& path)
+{
+	std::ifstream is(path, std::ios::binary);
+	if (!is)
+		throw std::runtime_error("unable to open frequency table " + path);
+	return read_frequency_table(is);
+}
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace dna
+{
+
+// Minimal lazy sequence: the coroutine body only runs while the consumer
+// advances an iterator, and stays suspended between values.
+template<typename T>
+class generator
+{
+public:
+	class promise_type
+	{
+		const T* value_ = nullptr;
+		std::exception_ptr exception_;
+	public:
+		generator get_return_object() noexcept
+		{
+			return generator(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		std::suspend_always initial_suspend() const noexcept
+		{
+			return {};
+		}
+
+		std::suspend_always final_suspend() const noexcept
+		{
+			return {};
+		}
+
+		std::suspend_always yield_value(const T& value) noexcept
+		{
+			value_ = std::addressof(value);
+			return {};
+		}
+
+		void return_void() const noexcept
+		{ }
+
+		void unhandled_exception() noexcept
+		{
+			exception_ = std::current_exception();
+		}
+
+		const T& value() const noexcept
+		{
+			return *value_;
+		}
+
+		void rethrow() const
+		{
+			if (exception_)
+				std::rethrow_exception(exception_);
+		}
+	};
+
+	using handle = std::coroutine_handle<promise_type>;
+
+	class iterator
+	{
+		handle coroutine_;
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = T;
+		using difference_type = long;
+
+		constexpr iterator() noexcept :
+				coroutine_(nullptr)
+		{ }
+
+		explicit iterator(handle coroutine) noexcept :
+				coroutine_(coroutine)
+		{ }
+
+		const T& operator*() const noexcept
+		{
+			return coroutine_.promise().value();
+		}
+
+		const T* operator->() const noexcept
+		{
+			return std::addressof(operator*());
+		}
+
+		iterator& operator++()
+		{
+			coroutine_.resume();
+			if (coroutine_.done())
+				coroutine_.promise().rethrow();
+			return *this;
+		}
+
+		void operator++(int)
+		{
+			operator++();
+		}
+
+		bool operator==(std::default_sentinel_t) const noexcept
+		{
+			return coroutine_ == nullptr || coroutine_.done();
+		}
+
+		bool operator!=(std::default_sentinel_t sentinel) const noexcept
+		{
+			return !operator==(sentinel);
+		}
+	};
+
+	generator(const generator&) = delete;
+	generator& operator=(const generator&) = delete;
+
+	generator(generator&& other) noexcept :
+			coroutine_(std::exchange(other.coroutine_, nullptr))
+	{ }
+
+	generator& operator=(generator&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			coroutine_ = std::exchange(other.coroutine_, nullptr);
+		}
+		return *this;
+	}
+
+	~generator()
+	{
+		reset();
+	}
+
+	// Resumes the coroutine; the returned iterator points at the first value.
+	iterator begin()
+	{
+		if (coroutine_ == nullptr)
+			return iterator();
+
+		coroutine_.resume();
+		if (coroutine_.done())
+			coroutine_.promise().rethrow();
+		return iterator(coroutine_);
+	}
+
+	std::default_sentinel_t end() const noexcept
+	{
+		return std::default_sentinel;
+	}
+
+private:
+	handle coroutine_;
+
+	explicit generator(handle coroutine) noexcept :
+			coroutine_(coroutine)
+	{ }
+
+	void reset() noexcept
+	{
+		if (coroutine_ != nullptr)
+			coroutine_.destroy();
+		coroutine_ = nullptr;
+	}
+};
+
+}
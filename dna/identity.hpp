@@ -0,0 +1,89 @@
+#pragma once
+
+#include "engine.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t min_identical_bases = std::size_t{1} << 16;
+
+// A stretch where both helices hold the same bases.
+struct identical_run
+{
+	std::size_t chromosome;
+	aligned_range range;
+};
+
+// Reports every maximal identical run of at least `min_length` bases inside
+// the mapped segments. Whole words of agreement just extend the run; a word
+// with mismatches closes it at its first mismatch (leading zeros) and opens
+// the next one after its last (trailing zeros), never looking at the bases
+// in between. Indels between segments always break a run.
+template<HelixStream S, typename F>
+void find_identical_runs(S& lhs, S& rhs, std::size_t chromosome, const alignment_map& map, std::size_t min_length,
+		F&& emit, std::size_t chunk_bases = default_chunk_bases)
+{
+	chunk_bases = std::max(word_bases, chunk_bases / word_bases * word_bases);
+
+	for (const auto& segment : map)
+	{
+		std::size_t run_start = 0;
+		std::size_t run = 0;
+		auto close = [&]()
+		{
+			if (run >= min_length && run > 0)
+				emit(identical_run{chromosome, aligned_range{segment.lhs + run_start, segment.rhs + run_start, run}});
+		};
+
+		for (std::size_t chunk = 0; chunk < segment.length; chunk += chunk_bases)
+		{
+			auto count = std::min(chunk_bases, segment.length - chunk);
+			auto lhs_window = load_packed(lhs, segment.lhs + chunk, count);
+			auto rhs_window = load_packed(rhs, segment.rhs + chunk, count);
+
+			for (std::size_t done = 0; done < count; done += word_bases)
+			{
+				auto bases = std::min(word_bases, count - done);
+				auto mask = window_mask(lhs_window, 0, rhs_window, 0, done, count);
+				if (mask == 0)
+				{
+					run += bases;
+					continue;
+				}
+
+				run += first_base(mask);
+				close();
+				auto last = last_base(mask);
+				run_start = chunk + done + last + 1;
+				run = bases - last - 1;
+			}
+		}
+		close();
+	}
+}
+
+// Every identical run of at least `min_length` bases, ordered by chromosome
+// and position, one task per chromosome.
+template<Person P>
+std::vector<identical_run> identical_segments(const P& lhs, const P& rhs, std::size_t min_length = min_identical_bases,
+		std::size_t threads = default_threads())
+{
+	auto chromosomes = comparable_chromosomes(lhs, rhs);
+	std::vector<std::vector<identical_run>> found(chromosomes.size());
+
+	parallel_for(chromosomes.size(), threads, [&](std::size_t i)
+	{
+		helix_of<P> lhs_helix = lhs.chromosome(chromosomes[i]);
+		helix_of<P> rhs_helix = rhs.chromosome(chromosomes[i]);
+		auto map = map_alignment(lhs_helix, rhs_helix, frame_helices(lhs_helix, rhs_helix));
+		find_identical_runs(lhs_helix, rhs_helix, chromosomes[i], map, min_length,
+				[&](const identical_run& run) { found[i].push_back(run); });
+	});
+
+	std::vector<identical_run> result;
+	for (auto& part : found)
+		result.insert(result.end(), part.begin(), part.end());
+	return result;
+}
+
+}
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <bit>
+#include "difference_store.hpp"
+
+namespace dna
+{
+
+static constexpr std::array<char, 8> interval_index_magic = {'D', 'N', 'A', 'I', 'V', 'X', '0', '1'};
+static constexpr std::size_t interval_header_bytes = interval_index_magic.size() + 8;
+static constexpr std::size_t interval_directory_bytes = 3 * 8;
+static constexpr std::size_t interval_record_bytes = 4 * 8;
+
+inline std::string interval_index_path_for(const std::string& store_path)
+{
+	return store_path + ".dnaivx";
+}
+
+// One entry per stored difference: the lhs bases it covers, the furthest end
+// in its implicit subtree and its record number in the store.
+struct indexed_interval
+{
+	std::uint64_t start;
+	std::uint64_t end;
+	std::uint64_t max;
+	std::uint64_t record;
+};
+
+// The implicit interval tree below, its build and its query, is ported from
+// cgranges by Heng Li (https://github.com/lh3/cgranges), which carries this
+// notice:
+//
+//   The MIT License
+//
+//   Copyright (c) 2019 Dana-Farber Cancer Institute
+//
+//   Permission is hereby granted, free of charge, to any person obtaining a
+//   copy of this software and associated documentation files (the
+//   "Software"), to deal in the Software without restriction, including
+//   without limitation the rights to use, copy, modify, merge, publish,
+//   distribute, sublicense, and/or sell copies of the Software, and to
+//   permit persons to whom the Software is furnished to do so, subject to
+//   the following conditions:
+//
+//   The above copyright notice and this permission notice shall be included
+//   in all copies or substantial portions of the Software.
+//
+//   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+namespace detail
+{
+
+// Implicit augmented interval tree over intervals sorted by start: the node
+// at index i sits on level k where k is the number of trailing ones of i.
+// Returns the top level, or -1 when there is nothing to index.
+inline int build_implicit_tree(std::vector<indexed_interval>& intervals)
+{
+	auto n = static_cast<std::int64_t>(intervals.size());
+	if (n == 0)
+		return -1;
+
+	std::int64_t last_i = 0;
+	std::uint64_t last = 0;
+	for (std::int64_t i = 0; i < n; i += 2)
+	{
+		last_i = i;
+		last = intervals[i].max = intervals[i].end;
+	}
+
+	int k = 1;
+	for (; (std::int64_t{1} << k) <= n; ++k)
+	{
+		std::int64_t x = std::int64_t{1} << (k - 1);
+		for (auto i = (x << 1) - 1; i < n; i += x << 2)
+		{
+			auto left = intervals[i - x].max;
+			auto right = i + x < n ? intervals[i + x].max : last;
+			intervals[i].max = std::max({intervals[i].end, left, right});
+		}
+
+		last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+		if (last_i < n && intervals[last_i].max > last)
+			last = intervals[last_i].max;
+	}
+	return k - 1;
+}
+
+}
+
+// Writes one implicit tree per chromosome over every record of the store.
+// The store is already sorted by chromosome then start, so trees are built
+// and written one chromosome at a time: memory holds the intervals of the
+// largest chromosome, 32 bytes per record, never the whole store.
+inline void write_interval_index(const difference_store& store, std::ostream& os)
+{
+	// A first pass sizes each chromosome so the directory can go up front; a
+	// tree's top level follows from its size alone.
+	std::vector<std::uint64_t> counts(store.chromosomes());
+	store.for_each([&](const difference& found) { ++counts[found.chromosome]; });
+
+	os.write(interval_index_magic.data(), interval_index_magic.size());
+	write_le<std::uint64_t>(os, counts.size());
+
+	auto offset = interval_header_bytes + counts.size() * interval_directory_bytes;
+	for (auto count : counts)
+	{
+		write_le<std::uint64_t>(os, offset);
+		write_le<std::uint64_t>(os, count);
+		write_le<std::int64_t>(os, count == 0 ? -1 : std::bit_width(count) - 1);
+		offset += count * interval_record_bytes;
+	}
+
+	std::vector<indexed_interval> intervals;
+	std::uint64_t record = 0;
+	for (std::size_t chromosome = 0; chromosome < counts.size(); ++chromosome)
+	{
+		intervals.clear();
+		for (auto i = store.first_block(chromosome); i < store.blocks() && store.block(i).first_chromosome <= chromosome; ++i)
+			store.decode_block(i, [&](const difference& found)
+			{
+				if (found.chromosome == chromosome)
+					intervals.push_back(indexed_interval{found.start, detail::difference_reach(found), 0, record++});
+			});
+		detail::build_implicit_tree(intervals);
+
+		for (const auto& interval : intervals)
+		{
+			write_le<std::uint64_t>(os, interval.start);
+			write_le<std::uint64_t>(os, interval.end);
+			write_le<std::uint64_t>(os, interval.max);
+			write_le<std::uint64_t>(os, interval.record);
+		}
+	}
+}
+
+inline void write_interval_index(const difference_store& store, const std::string& path)
+{
+	std::ofstream os(path, std::ios::binary | std::ios::trunc);
+	if (!os)
+		throw std::runtime_error("unable to create interval index " + path);
+	write_interval_index(store, os);
+}
+
+// Overlap queries walk the mapped tree in O(log n + k), touching only the
+// nodes on the way down and the matches.
+class interval_index
+{
+	mapped_file file_;
+	std::size_t chromosomes_;
+
+	indexed_interval at(const unsigned char* base, std::int64_t i) const noexcept
+	{
+		auto record = base + i * interval_record_bytes;
+		return indexed_interval{decode_le<std::uint64_t>(record), decode_le<std::uint64_t>(record + 8),
+				decode_le<std::uint64_t>(record + 16), decode_le<std::uint64_t>(record + 24)};
+	}
+public:
+	explicit interval_index(const std::string& path) :
+			file_(path),
+			chromosomes_(0)
+	{
+		if (file_.size() < interval_header_bytes ||
+				!std::equal(interval_index_magic.begin(), interval_index_magic.end(), file_.data(),
+						[](char expected, unsigned char found) { return static_cast<unsigned char>(expected) == found; }))
+			throw std::runtime_error("not an interval index " + path);
+
+		chromosomes_ = decode_le<std::uint64_t>(file_.data() + interval_index_magic.size());
+		if (file_.size() < interval_header_bytes + chromosomes_ * interval_directory_bytes)
+			throw std::runtime_error("corrupt interval index " + path);
+	}
+
+	std::size_t chromosomes() const noexcept
+	{
+		return chromosomes_;
+	}
+
+	// Calls f(interval) for each record overlapping [from, to) until f
+	// returns false.
+	template<typename F>
+	void visit(std::size_t chromosome, std::size_t from, std::size_t to, F&& f) const
+	{
+		if (chromosome >= chromosomes_ || from >= to)
+			return;
+
+		auto entry = file_.data() + interval_header_bytes + chromosome * interval_directory_bytes;
+		auto base = file_.data() + decode_le<std::uint64_t>(entry);
+		auto n = static_cast<std::int64_t>(decode_le<std::uint64_t>(entry + 8));
+		auto top = decode_le<std::int64_t>(entry + 16);
+		if (n == 0)
+			return;
+
+		struct node
+		{
+			std::int64_t level;
+			std::int64_t index;
+			bool left_done;
+		};
+
+		node stack[64];
+		int depth = 0;
+		stack[depth++] = node{top, (std::int64_t{1} << top) - 1, false};
+
+		while (depth > 0)
+		{
+			auto current = stack[--depth];
+			if (current.level <= 3)
+			{
+				auto first = current.index >> current.level << current.level;
+				auto last = std::min(n, first + (std::int64_t{1} << (current.level + 1)) - 1);
+				for (auto i = first; i < last; ++i)
+				{
+					auto interval = at(base, i);
+					if (interval.start >= to)
+						break;
+					if (from < interval.end && !f(interval))
+						return;
+				}
+			}
+			else if (!current.left_done)
+			{
+				auto left = current.index - (std::int64_t{1} << (current.level - 1));
+				stack[depth++] = node{current.level, current.index, true};
+				if (left >= n || at(base, left).max > from)
+					stack[depth++] = node{current.level - 1, left, false};
+			}
+			else if (current.index < n)
+			{
+				auto interval = at(base, current.index);
+				if (interval.start < to)
+				{
+					if (from < interval.end && !f(interval))
+						return;
+					stack[depth++] = node{current.level - 1, current.index + (std::int64_t{1} << (current.level - 1)), false};
+				}
+			}
+		}
+	}
+
+	std::vector<std::uint64_t> query(std::size_t chromosome, std::size_t from, std::size_t to) const
+	{
+		std::vector<std::uint64_t> records;
+		visit(chromosome, from, to, [&](const indexed_interval& found)
+		{
+			records.push_back(found.record);
+			return true;
+		});
+		std::sort(records.begin(), records.end());
+		return records;
+	}
+
+	bool any(std::size_t chromosome, std::size_t from, std::size_t to) const
+	{
+		bool found = false;
+		visit(chromosome, from, to, [&](const indexed_interval&)
+		{
+			found = true;
+			return false;
+		});
+		return found;
+	}
+};
+
+// Positions in `indexes` (one per stored pair) that hold a difference
+// overlapping [from, to) on `chromosome`.
+inline std::vector<std::size_t> differing_pairs(const std::vector<std::reference_wrapper<const interval_index>>& indexes,
+		std::size_t chromosome, std::size_t from, std::size_t to)
+{
+	std::vector<std::size_t> result;
+	for (std::size_t i = 0; i < indexes.size(); ++i)
+		if (indexes[i].get().any(chromosome, from, to))
+			result.push_back(i);
+	return result;
+}
+
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include "packed_sequence.hpp"
+
+namespace dna
+{
+
+static constexpr packed_word low_bits = 0x5555555555555555ULL;
+
+// The splitmix64 finalizer: every input bit flips about half the output
+// bits, so any slice of the result can serve as a hash.
+constexpr std::uint64_t mix_bits(std::uint64_t value) noexcept
+{
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9ull;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111ebull;
+	return value ^ (value >> 31);
+}
+
+// One bit per base, set on the low bit of every base that differs.
+constexpr packed_word mismatch_mask(packed_word lhs, packed_word rhs) noexcept
+{
+	auto diff = lhs ^ rhs;
+	return (diff | (diff >> 1)) & low_bits;
+}
+
+// Low bits of the first `bases` bases of a word.
+constexpr packed_word lead_mask(std::size_t bases) noexcept
+{
+	if (bases >= word_bases)
+		return low_bits;
+	return bases == 0 ? 0 : low_bits & (~packed_word{0} << (64 - 2 * bases));
+}
+
+// The 32 bases of a word read backwards on the other strand.
+constexpr packed_word reverse_complement(packed_word word) noexcept
+{
+	word = ~word;
+	word = ((word >> 2) & 0x3333333333333333ULL) | ((word & 0x3333333333333333ULL) << 2);
+	word = ((word >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((word & 0x0f0f0f0f0f0f0f0fULL) << 4);
+	return __builtin_bswap64(word);
+}
+
+constexpr packed_word base_bit(std::size_t index) noexcept
+{
+	return packed_word{1} << (62 - 2 * index);
+}
+
+constexpr std::size_t first_base(packed_word mask) noexcept
+{
+	return static_cast<std::size_t>(__builtin_clzll(mask)) / 2;
+}
+
+constexpr std::size_t last_base(packed_word mask) noexcept
+{
+	return word_bases - 1 - static_cast<std::size_t>(__builtin_ctzll(mask)) / 2;
+}
+
+constexpr std::size_t mismatch_count(packed_word mask) noexcept
+{
+	return static_cast<std::size_t>(__builtin_popcountll(mask));
+}
+
+// Mismatch mask of the 32 bases starting at `offset` in an aligned window.
+inline packed_word window_mask(const packed_sequence& lhs, std::size_t lhs_pos,
+		const packed_sequence& rhs, std::size_t rhs_pos, std::size_t offset, std::size_t count) noexcept
+{
+	auto n = std::min(word_bases, count - offset);
+	return mismatch_mask(lhs.word(lhs_pos + offset), rhs.word(rhs_pos + offset)) & lead_mask(n);
+}
+
+inline std::size_t count_mismatches(const packed_sequence& lhs, std::size_t lhs_pos,
+		const packed_sequence& rhs, std::size_t rhs_pos, std::size_t count) noexcept
+{
+	std::size_t total = 0;
+	for (std::size_t done = 0; done < count; done += word_bases)
+		total += mismatch_count(window_mask(lhs, lhs_pos, rhs, rhs_pos, done, count));
+	return total;
+}
+
+// Calls f(offset, length) for every maximal run of mismatching bases in the
+// window, offsets being relative to the start of the window.
+template<typename F>
+void for_each_mismatch_run(const packed_sequence& lhs, std::size_t lhs_pos,
+		const packed_sequence& rhs, std::size_t rhs_pos, std::size_t count, F&& f)
+{
+	std::size_t run_start = 0;
+	std::size_t run_length = 0;
+
+	for (std::size_t done = 0; done < count; done += word_bases)
+	{
+		auto mask = window_mask(lhs, lhs_pos, rhs, rhs_pos, done, count);
+		while (mask != 0)
+		{
+			auto index = first_base(mask);
+			mask &= ~base_bit(index);
+
+			auto position = done + index;
+			if (run_length != 0 && run_start + run_length == position)
+			{
+				++run_length;
+				continue;
+			}
+
+			if (run_length != 0)
+				f(run_start, run_length);
+			run_start = position;
+			run_length = 1;
+		}
+	}
+
+	if (run_length != 0)
+		f(run_start, run_length);
+}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "alignment_map.hpp"
+#include "generator.hpp"
+
+namespace dna
+{
+
+// Yields the differences of a range on demand. Each chunk is only read and
+// compared when the consumer asks past the previous one, so abandoning the
+// generator early skips the rest of the helices. Many of these can be driven
+// in turn from a single thread. This is an unaligned compare: bases are
+// paired at fixed positions, with no telomere frame and no indel handling.
+template<HelixStream S>
+generator<difference> lazy_differences(S lhs, S rhs, std::size_t chromosome, aligned_range range,
+		std::size_t chunk_bases = default_chunk_bases)
+{
+	difference_coalescer pending;
+	std::vector<difference> ready;
+	auto keep = [&](const difference& found) { ready.push_back(found); };
+
+	for (std::size_t done = 0; done < range.length; done += chunk_bases)
+	{
+		aligned_range chunk{range.lhs + done, range.rhs + done, std::min(chunk_bases, range.length - done)};
+		auto lhs_chunk = load_packed(lhs, chunk.lhs, chunk.length);
+		auto rhs_chunk = load_packed(rhs, chunk.rhs, chunk.length);
+		chunk.length = std::min(lhs_chunk.size(), rhs_chunk.size());
+
+		ready.clear();
+		compare_chunk(lhs_chunk, rhs_chunk, chromosome, chunk,
+				[&](const difference& found) { pending.push(found, keep); });
+
+		for (const auto& found : ready)
+			co_yield found;
+	}
+
+	ready.clear();
+	pending.flush(keep);
+	for (const auto& found : ready)
+		co_yield found;
+}
+
+// Same as compare_mapped, one chunk at a time: the gaps between segments
+// become indels and dense clusters are realigned, so this yields exactly
+// what the engine reports for the pair. Only building `map` reads the
+// helices up front.
+template<HelixStream S>
+generator<difference> lazy_differences(S lhs, S rhs, std::size_t chromosome, alignment_map map,
+		std::size_t chunk_bases = default_chunk_bases)
+{
+	std::vector<difference> ready;
+	auto keep = [&](const difference& found) { ready.push_back(found); };
+	indel_refiner<S> refiner(lhs, rhs);
+	auto refined = [&](const difference& found) { refiner.push(found, keep); };
+
+	for (std::size_t i = 0; i < map.size(); ++i)
+	{
+		if (i > 0)
+			compare_gap(lhs, rhs, chromosome, map[i - 1], map[i], refined);
+
+		const auto& range = map[i];
+		difference_coalescer pending;
+		for (std::size_t done = 0; done < range.length; done += chunk_bases)
+		{
+			aligned_range chunk{range.lhs + done, range.rhs + done, std::min(chunk_bases, range.length - done)};
+			auto lhs_chunk = load_packed(lhs, chunk.lhs, chunk.length);
+			auto rhs_chunk = load_packed(rhs, chunk.rhs, chunk.length);
+			chunk.length = std::min(lhs_chunk.size(), rhs_chunk.size());
+
+			compare_chunk(lhs_chunk, rhs_chunk, chromosome, chunk,
+					[&](const difference& found) { pending.push(found, refined); });
+
+			for (const auto& found : ready)
+				co_yield found;
+			ready.clear();
+		}
+		pending.flush(refined);
+	}
+
+	refiner.flush(keep);
+	for (const auto& found : ready)
+		co_yield found;
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dna
+{
+
+// Read-only mapping of a whole file, unmapped on destruction.
+class mapped_file
+{
+	const unsigned char* data_;
+	std::size_t size_;
+public:
+	explicit mapped_file(const std::string& path) :
+			data_(nullptr),
+			size_(0)
+	{
+		auto fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error("unable to open " + path);
+
+		struct stat info;
+		if (::fstat(fd, &info) != 0)
+		{
+			::close(fd);
+			throw std::runtime_error("unable to stat " + path);
+		}
+
+		size_ = static_cast<std::size_t>(info.st_size);
+		if (size_ > 0)
+		{
+			auto mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped == MAP_FAILED)
+			{
+				::close(fd);
+				throw std::runtime_error("unable to map " + path);
+			}
+			data_ = static_cast<const unsigned char*>(mapped);
+		}
+		::close(fd);
+	}
+
+	mapped_file(mapped_file&& other) noexcept :
+			data_(std::exchange(other.data_, nullptr)),
+			size_(std::exchange(other.size_, 0))
+	{ }
+
+	mapped_file& operator=(mapped_file&& other) noexcept
+	{
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+		return *this;
+	}
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	~mapped_file()
+	{
+		if (data_)
+			::munmap(const_cast<unsigned char*>(data_), size_);
+	}
+
+	const unsigned char* data() const noexcept
+	{
+		return data_;
+	}
+
+	std::size_t size() const noexcept
+	{
+		return size_;
+	}
+};
+
+}
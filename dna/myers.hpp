@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+#include <vector>
+#include "difference.hpp"
+#include "kernel.hpp"
+
+namespace dna
+{
+
+// Longest window of clustered mismatches handed to the aligner.
+static constexpr std::size_t myers_max_bases = 64;
+
+// A run of identical edits, offsets relative to the two aligned windows.
+struct edit_run
+{
+	difference_kind kind;
+	std::size_t lhs;
+	std::size_t rhs;
+	std::size_t length;
+};
+
+struct window_alignment
+{
+	std::size_t distance;
+	std::vector<edit_run> edits;
+};
+
+namespace detail
+{
+
+constexpr std::uint32_t reverse_bits(std::uint32_t x) noexcept
+{
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+	x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+	return (x >> 16) | (x << 16);
+}
+
+// Gathers the low bit of every base into 32 contiguous bits, bit i being
+// base i of the word.
+constexpr std::uint32_t gather_bases(packed_word x) noexcept
+{
+	x &= low_bits;
+	x = (x | (x >> 1)) & 0x3333333333333333ULL;
+	x = (x | (x >> 2)) & 0x0f0f0f0f0f0f0f0fULL;
+	x = (x | (x >> 4)) & 0x00ff00ff00ff00ffULL;
+	x = (x | (x >> 8)) & 0x0000ffff0000ffffULL;
+	x = (x | (x >> 16)) & 0x00000000ffffffffULL;
+	return reverse_bits(static_cast<std::uint32_t>(x));
+}
+
+constexpr packed_word row_mask(std::size_t rows) noexcept
+{
+	return rows >= 64 ? ~packed_word{0} : (packed_word{1} << rows) - 1;
+}
+
+}
+
+// Myers' match vectors straight from packed words: bit i of masks[b] is set
+// when base i of the pattern is b.
+inline std::array<packed_word, 4> pattern_masks(const packed_sequence& pattern, std::size_t position, std::size_t length)
+{
+	std::array<packed_word, 4> masks{};
+	for (std::size_t half = 0; half * word_bases < length; ++half)
+	{
+		auto word = pattern.word(position + half * word_bases);
+		for (std::size_t b = 0; b < masks.size(); ++b)
+		{
+			auto diff = word ^ (low_bits * b);
+			auto equal = detail::gather_bases(~(diff | (diff >> 1)));
+			masks[b] |= static_cast<packed_word>(equal) << (half * word_bases);
+		}
+	}
+
+	for (auto& mask : masks)
+		mask &= detail::row_mask(length);
+	return masks;
+}
+
+namespace detail
+{
+
+// One column step of Myers' recurrence over a 64-row block. `carry` is the
+// horizontal delta entering the top row and the delta leaving the bottom
+// row is returned, as in the blocked variant of the algorithm.
+inline int advance_block(packed_word& pv, packed_word& mv, packed_word eq, packed_word rows, int carry) noexcept
+{
+	auto xv = eq | mv;
+	if (carry < 0)
+		eq |= 1;
+	auto xh = (((eq & pv) + pv) ^ pv) | eq;
+	auto ph = mv | ~(xh | pv);
+	auto mh = pv & xh;
+
+	auto high = (rows >> 1) + 1;
+	int out = 0;
+	if (ph & high)
+		out = 1;
+	if (mh & high)
+		out = -1;
+
+	ph <<= 1;
+	mh <<= 1;
+	if (carry < 0)
+		mh |= 1;
+	else if (carry > 0)
+		ph |= 1;
+
+	pv = (mh | ~(xv | ph)) & rows;
+	mv = ph & xv & rows;
+	return out;
+}
+
+}
+
+// Global edit distance between lhs[lhs_pos, +m) and rhs[rhs_pos, +n) with
+// Myers' bit-vector recurrence in 64-row blocks. A cell further than `band`
+// from the main diagonal already costs more than `band`, so each column
+// only computes the blocks that cross the band; blocks above it are
+// dropped and blocks below it are added as the band slides down. Pairs
+// whose distance exceeds `band` are rejected. The band's columns are kept
+// so the edits can be traced back.
+inline std::optional<window_alignment> banded_align(const packed_sequence& lhs, std::size_t lhs_pos, std::size_t m,
+		const packed_sequence& rhs, std::size_t rhs_pos, std::size_t n, std::size_t band)
+{
+	if (m == 0 || (m > n ? m - n : n - m) > band)
+		return std::nullopt;
+
+	auto blocks = (m + 63) / 64;
+	auto block_rows = [&](std::size_t b) { return detail::row_mask(std::min<std::size_t>(64, m - 64 * b)); };
+	auto block_of = [](std::size_t row) { return (row - 1) / 64; };
+
+	std::vector<std::array<packed_word, 4>> peq(blocks);
+	for (std::size_t b = 0; b < blocks; ++b)
+		peq[b] = pattern_masks(lhs, lhs_pos + 64 * b, std::min<std::size_t>(64, m - 64 * b));
+
+	// One record per column: the band's first block, the distance on the
+	// row just above it and where its block vectors start in pv/mv.
+	struct column
+	{
+		std::size_t first;
+		std::size_t last;
+		long top;
+		std::size_t words;
+	};
+
+	std::vector<packed_word> live_pv(blocks);
+	std::vector<packed_word> live_mv(blocks, 0);
+	std::vector<long> score(blocks);
+	for (std::size_t b = 0; b < blocks; ++b)
+	{
+		live_pv[b] = block_rows(b);
+		score[b] = static_cast<long>(std::min(m, 64 * b + 64));
+	}
+
+	std::size_t first = 0;
+	std::size_t last = block_of(std::clamp<std::size_t>(band, 1, m));
+	long top = 0;
+
+	std::vector<column> columns;
+	std::vector<packed_word> pv;
+	std::vector<packed_word> mv;
+	columns.reserve(n + 1);
+	auto keep = [&]()
+	{
+		columns.push_back(column{first, last, top, pv.size()});
+		pv.insert(pv.end(), live_pv.begin() + first, live_pv.begin() + last + 1);
+		mv.insert(mv.end(), live_mv.begin() + first, live_mv.begin() + last + 1);
+	};
+	keep();
+
+	for (std::size_t j = 1; j <= n; ++j)
+	{
+		auto wanted_first = block_of(j > band ? j - band : 1);
+		auto wanted_last = block_of(std::min(m, j + band));
+		for (; last < wanted_last; ++last)
+		{
+			live_pv[last + 1] = block_rows(last + 1);
+			live_mv[last + 1] = 0;
+			score[last + 1] = score[last] + __builtin_popcountll(block_rows(last + 1));
+		}
+		for (; first < wanted_first; ++first)
+			top = score[first];
+
+		auto base = static_cast<std::size_t>(rhs.at(rhs_pos + j - 1));
+		int carry = 1;
+		++top;
+		for (auto b = first; b <= last; ++b)
+		{
+			carry = detail::advance_block(live_pv[b], live_mv[b], peq[b][base], block_rows(b), carry);
+			score[b] += carry;
+		}
+		keep();
+	}
+
+	auto distance = score[blocks - 1];
+	if (last != blocks - 1 || distance > static_cast<long>(band))
+		return std::nullopt;
+
+	auto distance_at = [&](std::size_t i, std::size_t j)
+	{
+		static constexpr long outside = std::numeric_limits<long>::max() / 2;
+		const auto& col = columns[j];
+		if (i < 64 * col.first)
+			return outside;
+		if (i == 64 * col.first)
+			return col.top;
+		auto block = block_of(i);
+		if (block > col.last)
+			return outside;
+
+		auto value = col.top;
+		for (auto b = col.first; b <= block; ++b)
+		{
+			auto below = b == block ? detail::row_mask(i - 64 * b) : ~packed_word{0};
+			auto word = col.words + (b - col.first);
+			value += __builtin_popcountll(pv[word] & below) - __builtin_popcountll(mv[word] & below);
+		}
+		return value;
+	};
+
+	window_alignment result{static_cast<std::size_t>(distance), {}};
+	auto push = [&](difference_kind kind, std::size_t i, std::size_t j)
+	{
+		auto& edits = result.edits;
+		if (!edits.empty() && edits.back().kind == kind &&
+				edits.back().lhs == i + (kind == difference_kind::insertion ? 0 : 1) &&
+				edits.back().rhs == j + (kind == difference_kind::deletion ? 0 : 1))
+		{
+			edits.back().lhs = i;
+			edits.back().rhs = j;
+			++edits.back().length;
+			return;
+		}
+		edits.push_back(edit_run{kind, i, j, 1});
+	};
+
+	auto i = m;
+	auto j = n;
+	while (i > 0 || j > 0)
+	{
+		auto here = distance_at(i, j);
+		if (i > 0 && j > 0)
+		{
+			auto same = lhs.at(lhs_pos + i - 1) == rhs.at(rhs_pos + j - 1);
+			if (distance_at(i - 1, j - 1) + (same ? 0 : 1) == here)
+			{
+				--i;
+				--j;
+				if (!same)
+					push(difference_kind::substitution, i, j);
+				continue;
+			}
+		}
+
+		if (i > 0 && distance_at(i - 1, j) + 1 == here)
+		{
+			--i;
+			push(difference_kind::deletion, i, j);
+		}
+		else
+		{
+			--j;
+			push(difference_kind::insertion, i, j);
+		}
+	}
+
+	std::reverse(result.edits.begin(), result.edits.end());
+	return result;
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <span>
+#include "packed_sequence.hpp"
+
+namespace dna
+{
+
+// A helix stream over bases already in memory, so the engine can align and
+// compare a window without going back to the person. `bases` hold the helix
+// from base `origin` on, which must start a byte. Reads outside them come
+// back empty, as reads past the end do; size() still reports the whole helix.
+class packed_helix
+{
+	static constexpr std::size_t read_bytes = 4096;
+
+	const packed_sequence* bases_;
+	std::size_t first_;
+	long size_;
+	std::size_t position_;
+	std::vector<std::byte> scratch_;
+public:
+	packed_helix(const packed_sequence& bases, std::size_t origin, long size) :
+			bases_(&bases),
+			first_(origin / packed_size::value),
+			size_(size),
+			position_(0),
+			scratch_()
+	{ }
+
+	packed_helix(const packed_helix& other) :
+			packed_helix(*other.bases_, other.first_ * packed_size::value, other.size_)
+	{ }
+
+	void seek(long offset)
+	{
+		position_ = static_cast<std::size_t>(offset);
+	}
+
+	long size() const
+	{
+		return size_;
+	}
+
+	// Whether the byte at `offset` is held in memory.
+	bool holds(std::size_t offset) const noexcept
+	{
+		return offset >= first_ && offset < first_ + (bases_->size() + packed_size::value - 1) / packed_size::value;
+	}
+
+	sequence_buffer<std::span<const std::byte>> read()
+	{
+		constexpr auto word_bytes = sizeof(packed_word);
+		auto count = (bases_->size() + packed_size::value - 1) / packed_size::value;
+
+		scratch_.clear();
+		if (holds(position_))
+		{
+			const auto& words = bases_->words();
+			auto last = std::min(first_ + count, position_ + read_bytes);
+			for (auto k = position_ - first_; k < last - first_; ++k)
+				scratch_.push_back(static_cast<std::byte>((words[k / word_bytes] >> (8 * (word_bytes - 1 - k % word_bytes))) & 0xff));
+		}
+
+		position_ += scratch_.size();
+		return sequence_buffer<std::span<const std::byte>>(std::span<const std::byte>(scratch_));
+	}
+};
+
+}
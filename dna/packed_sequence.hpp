@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "person.hpp"
+
+namespace dna
+{
+
+using packed_word = std::uint64_t;
+
+static constexpr std::size_t word_bases = sizeof(packed_word) * packed_size::value;
+
+// Helix streams are addressed in packed bytes: size() and seek() both count
+// four bases per unit.
+template<HelixStream S>
+constexpr std::size_t helix_size(const S& helix)
+{
+	return static_cast<std::size_t>(helix.size()) * packed_size::value;
+}
+
+constexpr base base_at(packed_word word, std::size_t index) noexcept
+{
+	return static_cast<base>((word >> (62 - 2 * index)) & 0x3);
+}
+
+constexpr packed_word base_word(base value, std::size_t index) noexcept
+{
+	return static_cast<packed_word>(value) << (62 - 2 * index);
+}
+
+class packed_sequence
+{
+	std::vector<packed_word> words_;
+	std::size_t skew_;
+	std::size_t size_;
+public:
+	packed_sequence() noexcept :
+			words_(),
+			skew_(0),
+			size_(0)
+	{ }
+
+	packed_sequence(std::vector<packed_word> words, std::size_t size, std::size_t skew = 0) :
+			words_(std::move(words)),
+			skew_(skew),
+			size_(size)
+	{ }
+
+	std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	const std::vector<packed_word>& words() const noexcept
+	{
+		return words_;
+	}
+
+	base at(std::size_t index) const noexcept
+	{
+		auto physical = index + skew_;
+		return base_at(words_[physical / word_bases], physical % word_bases);
+	}
+
+	base operator[](std::size_t index) const noexcept
+	{
+		return at(index);
+	}
+
+	// The 32 bases starting at any base index. Bases past the end read as zero.
+	packed_word word(std::size_t index) const noexcept
+	{
+		if (index >= size_)
+			return 0;
+
+		auto physical = index + skew_;
+		auto offset = physical / word_bases;
+		auto shift = (physical % word_bases) * 2;
+
+		packed_word result = words_[offset] << shift;
+		if (shift != 0 && offset + 1 < words_.size())
+			result |= words_[offset + 1] >> (64 - shift);
+
+		auto remaining = size_ - index;
+		if (remaining < word_bases)
+			result &= ~packed_word{0} << (64 - 2 * remaining);
+		return result;
+	}
+
+	void push_back(base value)
+	{
+		auto physical = skew_ + size_;
+		if (physical % word_bases == 0)
+			words_.push_back(0);
+		words_.back() |= base_word(value, physical % word_bases);
+		++size_;
+	}
+};
+
+class packed_builder
+{
+	std::vector<packed_word> words_;
+	std::size_t bytes_;
+public:
+	explicit packed_builder(std::size_t reserve_bases = 0) :
+			words_(),
+			bytes_(0)
+	{
+		words_.reserve((reserve_bases + word_bases - 1) / word_bases);
+	}
+
+	void append(std::byte value)
+	{
+		constexpr auto word_bytes = sizeof(packed_word);
+		auto slot = bytes_ % word_bytes;
+		if (slot == 0)
+			words_.push_back(0);
+		words_.back() |= static_cast<packed_word>(value) << (8 * (word_bytes - 1 - slot));
+		++bytes_;
+	}
+
+	std::size_t bases() const noexcept
+	{
+		return bytes_ * packed_size::value;
+	}
+
+	packed_sequence finish(std::size_t skew, std::size_t size) &&
+	{
+		return packed_sequence(std::move(words_), std::min(size, bases() - std::min(skew, bases())), skew);
+	}
+};
+
+// Reads `count` bases starting at base `first`. Only the bytes that cover the
+// range are pulled from the stream, the rest of the helix is never touched.
+template<HelixStream S>
+packed_sequence load_packed(S& helix, std::size_t first, std::size_t count)
+{
+	auto first_byte = first / packed_size::value;
+	auto skew = first - first_byte * packed_size::value;
+	auto wanted = (skew + count + packed_size::value - 1) / packed_size::value;
+
+	packed_builder builder(skew + count);
+	helix.seek(static_cast<long>(first_byte));
+
+	std::size_t loaded = 0;
+	while (loaded < wanted)
+	{
+		const auto chunk = helix.read();
+		const auto& bytes = chunk.buffer();
+		auto available = static_cast<std::size_t>(bytes.size());
+		if (available == 0)
+			break;
+
+		for (std::size_t i = 0; i < available && loaded < wanted; ++i, ++loaded)
+			builder.append(bytes[i]);
+	}
+
+	return std::move(builder).finish(skew, count);
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dna
+{
+
+inline std::size_t default_threads() noexcept
+{
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs f(index) for every index in [0, count) on up to `threads` workers that
+// pull the next index from a shared counter. The first exception thrown by a
+// task is rethrown once every worker has stopped.
+template<typename F>
+void parallel_for(std::size_t count, std::size_t threads, F&& f)
+{
+	threads = std::max<std::size_t>(1, std::min(threads, count));
+	if (threads == 1)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+			f(i);
+		return;
+	}
+
+	std::atomic<std::size_t> next{0};
+	std::exception_ptr failure;
+	std::mutex failure_lock;
+
+	auto worker = [&]()
+	{
+		try
+		{
+			for (auto i = next++; i < count; i = next++)
+				f(i);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> guard(failure_lock);
+			if (!failure)
+				failure = std::current_exception();
+			next = count;
+		}
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+	for (std::size_t i = 1; i < threads; ++i)
+		workers.emplace_back(worker);
+	worker();
+
+	for (auto& t : workers)
+		t.join();
+
+	if (failure)
+		std::rethrow_exception(failure);
+}
+
+}
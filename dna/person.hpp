@@ -1,22 +1,23 @@
 #pragma once
 
+#include <concepts>
+#include <type_traits>
 #include "sequence_buffer.hpp"
 
 namespace dna
 {
 
 template<typename T>
-concept bool HelixStream = requires(T a) {
+concept HelixStream = requires(T a) {
 	{ a.seek(1000L) };
-	{ a.read() } -> sequence_buffer<ByteBuffer>
-	{ a.size() } -> std::size_t;
+	{ a.read().size() } -> std::convertible_to<std::size_t>;
+	{ a.size() } -> std::convertible_to<std::size_t>;
 };
 
-template<HelixStream T>
-concept bool Person = requires(T a) {
-	{ a.chromosome(1) } -> HelixStream
-	{ a.chromosomes() } -> std::size_t
+template<typename T>
+concept Person = requires(T a) {
+	requires HelixStream<std::remove_cvref_t<decltype(a.chromosome(1))>>;
+	{ a.chromosomes() } -> std::convertible_to<std::size_t>;
 };
 
 }
-
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <string>
+#include "binary_io.hpp"
+#include "engine.hpp"
+#include "sketch.hpp"
+
+namespace dna
+{
+
+static constexpr std::array<char, 8> person_index_magic_v1 = {'D', 'N', 'A', 'I', 'D', 'X', '0', '1'};
+static constexpr std::array<char, 8> person_index_magic = {'D', 'N', 'A', 'I', 'D', 'X', '0', '2'};
+static constexpr std::size_t person_index_header_bytes = person_index_magic.size() + 8;
+static constexpr std::size_t person_index_record_bytes = 5 * 8;
+
+// Telomere bounds of every chromosome of one person, computed once and kept
+// beside the genome. Records have a fixed size so a single chromosome can be
+// fetched with one seek and one read.
+//
+// Version 2 appends a sketch section after the records: the slot width
+// followed by one fixed-size slot (hash count, then the hashes padded to the
+// width) per chromosome. Version 1 files load with no sketches.
+struct person_index
+{
+	std::vector<telomere_bounds> chromosomes;
+	std::vector<minhash_sketch> sketches;
+};
+
+inline std::string index_path_for(const std::string& genome_path)
+{
+	return genome_path + ".dnaidx";
+}
+
+template<Person P>
+person_index build_person_index(const P& person, std::size_t threads = default_threads())
+{
+	person_index index{std::vector<telomere_bounds>(person.chromosomes()),
+			std::vector<minhash_sketch>(person.chromosomes())};
+	parallel_for(person.chromosomes(), threads, [&](std::size_t i)
+	{
+		helix_of<P> helix = person.chromosome(i);
+		index.chromosomes[i] = find_telomeres(helix);
+		index.sketches[i] = sketch_helix(helix);
+	});
+	return index;
+}
+
+inline void write_person_index(const person_index& index, std::ostream& os)
+{
+	os.write(person_index_magic.data(), person_index_magic.size());
+	write_le<std::uint64_t>(os, index.chromosomes.size());
+
+	for (const auto& bounds : index.chromosomes)
+	{
+		write_le<std::uint64_t>(os, bounds.head_end);
+		write_le<std::uint64_t>(os, bounds.head_repeats);
+		write_le<std::uint64_t>(os, bounds.tail_begin);
+		write_le<std::uint64_t>(os, bounds.tail_repeats);
+		write_le<std::uint64_t>(os, bounds.size);
+	}
+
+	std::size_t width = 0;
+	for (const auto& sketch : index.sketches)
+		width = std::max(width, sketch.hashes.size());
+	write_le<std::uint64_t>(os, width);
+
+	for (std::size_t i = 0; i < index.chromosomes.size(); ++i)
+	{
+		const auto* hashes = i < index.sketches.size() ? &index.sketches[i].hashes : nullptr;
+		auto count = hashes ? hashes->size() : 0;
+		write_le<std::uint64_t>(os, count);
+		for (std::size_t h = 0; h < width; ++h)
+			write_le<std::uint64_t>(os, h < count ? (*hashes)[h] : 0);
+	}
+}
+
+inline void write_person_index(const person_index& index, const std::string& path)
+{
+	std::ofstream os(path, std::ios::binary | std::ios::trunc);
+	if (!os)
+		throw std::runtime_error("unable to create person index " + path);
+	write_person_index(index, os);
+}
+
+namespace detail
+{
+
+struct index_header
+{
+	std::size_t version;
+	std::size_t count;
+};
+
+inline index_header read_index_header(std::istream& is)
+{
+	std::array<char, 8> magic{};
+	is.read(magic.data(), magic.size());
+	if (!is || (magic != person_index_magic && magic != person_index_magic_v1))
+		throw std::runtime_error("not a person index");
+	return index_header{magic == person_index_magic ? 2u : 1u, read_le<std::uint64_t>(is)};
+}
+
+inline minhash_sketch read_index_sketch(std::istream& is, std::size_t width)
+{
+	auto count = read_le<std::uint64_t>(is);
+	if (count > width)
+		throw std::runtime_error("corrupt person index sketch");
+
+	minhash_sketch sketch;
+	sketch.hashes.reserve(count);
+	for (std::size_t h = 0; h < width; ++h)
+	{
+		auto hash = read_le<std::uint64_t>(is);
+		if (h < count)
+			sketch.hashes.push_back(hash);
+	}
+	return sketch;
+}
+
+inline telomere_bounds read_index_record(std::istream& is)
+{
+	unsigned char record[person_index_record_bytes];
+	if (!is.read(reinterpret_cast<char*>(record), sizeof(record)))
+		throw std::runtime_error("truncated person index");
+
+	return telomere_bounds{
+			decode_le<std::uint64_t>(record),
+			decode_le<std::uint64_t>(record + 8),
+			decode_le<std::uint64_t>(record + 16),
+			decode_le<std::uint64_t>(record + 24),
+			decode_le<std::uint64_t>(record + 32)};
+}
+
+}
+
+inline person_index read_person_index(std::istream& is)
+{
+	auto header = detail::read_index_header(is);
+
+	person_index index;
+	index.chromosomes.reserve(header.count);
+	for (std::size_t i = 0; i < header.count; ++i)
+		index.chromosomes.push_back(detail::read_index_record(is));
+
+	if (header.version >= 2)
+	{
+		auto width = read_le<std::uint64_t>(is);
+		index.sketches.reserve(header.count);
+		for (std::size_t i = 0; i < header.count; ++i)
+			index.sketches.push_back(detail::read_index_sketch(is, width));
+	}
+	return index;
+}
+
+inline person_index read_person_index(const std::string& path)
+{
+	std::ifstream is(path, std::ios::binary);
+	if (!is)
+		throw std::runtime_error("unable to open person index " + path);
+	return read_person_index(is);
+}
+
+// Only the header and the requested record are read.
+inline telomere_bounds read_index_entry(const std::string& path, std::size_t chromosome)
+{
+	std::ifstream is(path, std::ios::binary);
+	if (!is)
+		throw std::runtime_error("unable to open person index " + path);
+
+	auto header = detail::read_index_header(is);
+	if (chromosome >= header.count)
+		throw std::out_of_range("chromosome not in person index " + path);
+
+	is.seekg(static_cast<std::streamoff>(person_index_header_bytes + chromosome * person_index_record_bytes));
+	return detail::read_index_record(is);
+}
+
+// Only the header, the width and the requested sketch slot are read.
+inline minhash_sketch read_index_sketch(const std::string& path, std::size_t chromosome)
+{
+	std::ifstream is(path, std::ios::binary);
+	if (!is)
+		throw std::runtime_error("unable to open person index " + path);
+
+	auto header = detail::read_index_header(is);
+	if (header.version < 2)
+		throw std::runtime_error("person index has no sketches " + path);
+	if (chromosome >= header.count)
+		throw std::out_of_range("chromosome not in person index " + path);
+
+	is.seekg(static_cast<std::streamoff>(person_index_header_bytes + header.count * person_index_record_bytes));
+	auto width = read_le<std::uint64_t>(is);
+	is.seekg(static_cast<std::streamoff>(chromosome * (width + 1) * 8), std::ios::cur);
+	return detail::read_index_sketch(is, width);
+}
+
+}
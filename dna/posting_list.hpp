@@ -0,0 +1,280 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace dna
+{
+
+// Sorted set of person ids in roaring layout: ids are split on their high 16
+// bits into containers that hold the low halves either as a sorted array or,
+// once that grows past 4096 entries, as a 65536 bit map.
+class posting_list
+{
+public:
+	static constexpr std::size_t array_limit = 4096;
+	static constexpr std::size_t bitmap_words = 1024;
+
+	using bitmap = std::array<std::uint64_t, bitmap_words>;
+
+	struct container
+	{
+		std::uint16_t key;
+		std::uint32_t cardinality;
+		std::vector<std::uint16_t> values;
+		std::vector<std::uint64_t> bits;
+
+		bool is_bitmap() const noexcept
+		{
+			return !bits.empty();
+		}
+
+		bool contains(std::uint16_t low) const noexcept
+		{
+			if (is_bitmap())
+				return bits[low >> 6] >> (low & 63) & 1;
+			return std::binary_search(values.begin(), values.end(), low);
+		}
+
+		void to_bitmap()
+		{
+			bits.assign(bitmap_words, 0);
+			for (auto low : values)
+				bits[low >> 6] |= std::uint64_t{1} << (low & 63);
+			values.clear();
+			values.shrink_to_fit();
+		}
+
+		void to_array()
+		{
+			values.clear();
+			for (std::size_t w = 0; w < bitmap_words; ++w)
+			{
+				for (auto word = bits[w]; word != 0; word &= word - 1)
+					values.push_back(static_cast<std::uint16_t>(w * 64 + __builtin_ctzll(word)));
+			}
+			bits.clear();
+			bits.shrink_to_fit();
+		}
+
+		void settle()
+		{
+			if (is_bitmap() && cardinality <= array_limit)
+				to_array();
+			else if (!is_bitmap() && cardinality > array_limit)
+				to_bitmap();
+		}
+	};
+
+private:
+	std::vector<container> containers_;
+	std::uint32_t last_ = 0;
+
+	// The highest id held, read off the last container; the list must not be
+	// empty. Lists built by push_back keep it in last_, set operations
+	// recompute it once.
+	std::uint32_t highest() const noexcept
+	{
+		const auto& last = containers_.back();
+		std::uint32_t high = std::uint32_t{last.key} << 16;
+		if (!last.is_bitmap())
+			return high | last.values.back();
+
+		auto w = bitmap_words;
+		while (last.bits[w - 1] == 0)
+			--w;
+		return high | static_cast<std::uint32_t>((w - 1) * 64 + 63 - __builtin_clzll(last.bits[w - 1]));
+	}
+
+	static container make_bitmap(std::uint16_t key)
+	{
+		return container{key, 0, {}, std::vector<std::uint64_t>(bitmap_words, 0)};
+	}
+
+	static std::uint32_t count_bits(const std::vector<std::uint64_t>& bits) noexcept
+	{
+		std::uint32_t total = 0;
+		for (auto word : bits)
+			total += static_cast<std::uint32_t>(__builtin_popcountll(word));
+		return total;
+	}
+
+	static container intersect(const container& lhs, const container& rhs)
+	{
+		container result{lhs.key, 0, {}, {}};
+		if (lhs.is_bitmap() && rhs.is_bitmap())
+		{
+			result.bits.resize(bitmap_words);
+			for (std::size_t w = 0; w < bitmap_words; ++w)
+				result.bits[w] = lhs.bits[w] & rhs.bits[w];
+			result.cardinality = count_bits(result.bits);
+		}
+		else if (lhs.is_bitmap() || rhs.is_bitmap())
+		{
+			const auto& values = lhs.is_bitmap() ? rhs.values : lhs.values;
+			const auto& bits = lhs.is_bitmap() ? lhs.bits : rhs.bits;
+			for (auto low : values)
+				if (bits[low >> 6] >> (low & 63) & 1)
+					result.values.push_back(low);
+			result.cardinality = static_cast<std::uint32_t>(result.values.size());
+		}
+		else
+		{
+			std::set_intersection(lhs.values.begin(), lhs.values.end(), rhs.values.begin(), rhs.values.end(),
+					std::back_inserter(result.values));
+			result.cardinality = static_cast<std::uint32_t>(result.values.size());
+		}
+		result.settle();
+		return result;
+	}
+
+	static container unite(const container& lhs, const container& rhs)
+	{
+		container result{lhs.key, 0, {}, {}};
+		if (lhs.is_bitmap() || rhs.is_bitmap() || lhs.cardinality + rhs.cardinality > array_limit)
+		{
+			result = make_bitmap(lhs.key);
+			for (const auto* side : {&lhs, &rhs})
+			{
+				if (side->is_bitmap())
+				{
+					for (std::size_t w = 0; w < bitmap_words; ++w)
+						result.bits[w] |= side->bits[w];
+				}
+				else
+				{
+					for (auto low : side->values)
+						result.bits[low >> 6] |= std::uint64_t{1} << (low & 63);
+				}
+			}
+			result.cardinality = count_bits(result.bits);
+		}
+		else
+		{
+			std::set_union(lhs.values.begin(), lhs.values.end(), rhs.values.begin(), rhs.values.end(),
+					std::back_inserter(result.values));
+			result.cardinality = static_cast<std::uint32_t>(result.values.size());
+		}
+		result.settle();
+		return result;
+	}
+public:
+	posting_list() = default;
+
+	const std::vector<container>& containers() const noexcept
+	{
+		return containers_;
+	}
+
+	// Ids must be added in increasing order.
+	void push_back(std::uint32_t id)
+	{
+		if (!containers_.empty() && id <= last_)
+			throw std::invalid_argument("posting list ids must be added in increasing order");
+		last_ = id;
+
+		auto key = static_cast<std::uint16_t>(id >> 16);
+		auto low = static_cast<std::uint16_t>(id & 0xffff);
+
+		if (containers_.empty() || containers_.back().key != key)
+			containers_.push_back(container{key, 0, {}, {}});
+
+		auto& last = containers_.back();
+		if (last.is_bitmap())
+			last.bits[low >> 6] |= std::uint64_t{1} << (low & 63);
+		else
+			last.values.push_back(low);
+		if (++last.cardinality == array_limit + 1)
+			last.to_bitmap();
+	}
+
+	std::size_t size() const noexcept
+	{
+		std::size_t total = 0;
+		for (const auto& each : containers_)
+			total += each.cardinality;
+		return total;
+	}
+
+	bool empty() const noexcept
+	{
+		return containers_.empty();
+	}
+
+	bool contains(std::uint32_t id) const noexcept
+	{
+		auto key = static_cast<std::uint16_t>(id >> 16);
+		auto found = std::lower_bound(containers_.begin(), containers_.end(), key,
+				[](const container& each, std::uint16_t wanted) { return each.key < wanted; });
+		return found != containers_.end() && found->key == key && found->contains(static_cast<std::uint16_t>(id));
+	}
+
+	std::vector<std::uint32_t> ids() const
+	{
+		std::vector<std::uint32_t> result;
+		result.reserve(size());
+		for (const auto& each : containers_)
+		{
+			auto high = static_cast<std::uint32_t>(each.key) << 16;
+			if (each.is_bitmap())
+			{
+				for (std::size_t w = 0; w < bitmap_words; ++w)
+					for (auto word = each.bits[w]; word != 0; word &= word - 1)
+						result.push_back(high | static_cast<std::uint32_t>(w * 64 + __builtin_ctzll(word)));
+			}
+			else
+			{
+				for (auto low : each.values)
+					result.push_back(high | low);
+			}
+		}
+		return result;
+	}
+
+	friend posting_list operator&(const posting_list& lhs, const posting_list& rhs)
+	{
+		posting_list result;
+		auto l = lhs.containers_.begin();
+		auto r = rhs.containers_.begin();
+		while (l != lhs.containers_.end() && r != rhs.containers_.end())
+		{
+			if (l->key < r->key)
+				++l;
+			else if (r->key < l->key)
+				++r;
+			else
+			{
+				auto both = intersect(*l++, *r++);
+				if (both.cardinality > 0)
+					result.containers_.push_back(std::move(both));
+			}
+		}
+		if (!result.empty())
+			result.last_ = result.highest();
+		return result;
+	}
+
+	friend posting_list operator|(const posting_list& lhs, const posting_list& rhs)
+	{
+		posting_list result;
+		auto l = lhs.containers_.begin();
+		auto r = rhs.containers_.begin();
+		while (l != lhs.containers_.end() || r != rhs.containers_.end())
+		{
+			if (r == rhs.containers_.end() || (l != lhs.containers_.end() && l->key < r->key))
+				result.containers_.push_back(*l++);
+			else if (l == lhs.containers_.end() || r->key < l->key)
+				result.containers_.push_back(*r++);
+			else
+				result.containers_.push_back(unite(*l++, *r++));
+		}
+		if (!result.empty())
+			result.last_ = result.highest();
+		return result;
+	}
+};
+
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <limits>
+#include "binary_io.hpp"
+#include "engine.hpp"
+#include "mapped_file.hpp"
+
+namespace dna
+{
+
+static constexpr std::array<char, 8> track_magic = {'D', 'N', 'A', 'T', 'R', 'K', '0', '1'};
+static constexpr std::size_t track_header_bytes = track_magic.size() + 3 * 8;
+static constexpr std::size_t track_directory_bytes = 2 * 8;
+static constexpr std::size_t profile_window_bases = 1000;
+static constexpr std::size_t profile_step_bases = 100;
+static constexpr std::size_t profile_chunk_bases = std::size_t{1} << 20;
+
+namespace detail
+{
+
+// Mismatch bits of lhs bases [first, first + 32 * masks.size()) on a grid of
+// words starting at `first`. Bases inside the frame but outside every mapped
+// segment count as mismatches, bases outside the frame as matches.
+template<HelixStream S>
+std::vector<packed_word> profile_masks(S& lhs, S& rhs, const alignment_frame& frame, const alignment_map& map,
+		std::size_t first, std::size_t bases)
+{
+	std::vector<packed_word> masks((bases + word_bases - 1) / word_bases, 0);
+	auto place = [&](std::size_t position, packed_word mask, std::size_t count)
+	{
+		auto offset = position - first;
+		auto shift = 2 * (offset % word_bases);
+		auto index = offset / word_bases;
+		auto keep = ~(lead_mask(count) | lead_mask(count) << 1);
+		masks[index] = (masks[index] & ~(~keep >> shift)) | mask >> shift;
+		if (shift != 0 && index + 1 < masks.size())
+			masks[index + 1] = (masks[index + 1] & ~(~keep << (64 - shift))) | mask << (64 - shift);
+	};
+
+	auto from = std::max(first, frame.lhs_begin);
+	auto to = std::min(first + bases, frame.lhs_end);
+	for (auto position = from; position < to; position += std::min(word_bases, to - position))
+		place(position, lead_mask(std::min(word_bases, to - position)), std::min(word_bases, to - position));
+
+	for (const auto& segment : map)
+	{
+		auto begin = std::max(from, segment.lhs);
+		auto end = std::min(to, segment.lhs + segment.length);
+		if (begin >= end)
+			continue;
+
+		auto count = end - begin;
+		auto lhs_window = load_packed(lhs, begin, count);
+		auto rhs_window = load_packed(rhs, segment.rhs + (begin - segment.lhs), count);
+		for (std::size_t done = 0; done < count; done += word_bases)
+			place(begin + done, window_mask(lhs_window, 0, rhs_window, 0, done, count),
+					std::min(word_bases, count - done));
+	}
+	return masks;
+}
+
+}
+
+// Calls emit(start, mismatches) for every window of `window_bases` starting
+// at multiples of `step_bases` along the whole lhs helix. Mismatch masks are
+// built a chunk at a time and turned into per-word prefix sums, so each
+// window is two lookups and two partial-word popcounts.
+template<HelixStream S, typename F>
+void divergence_profile(S& lhs, S& rhs, const alignment_frame& frame, const alignment_map& map, F&& emit,
+		std::size_t window_bases = profile_window_bases, std::size_t step_bases = profile_step_bases)
+{
+	auto size = helix_size(lhs);
+	if (size == 0 || window_bases == 0 || step_bases == 0)
+		return;
+
+	auto windows = size <= window_bases ? 1 : (size - window_bases) / step_bases + 1;
+	auto per_chunk = std::max<std::size_t>(1, profile_chunk_bases / step_bases);
+
+	for (std::size_t first_window = 0; first_window < windows; first_window += per_chunk)
+	{
+		auto last_window = std::min(windows, first_window + per_chunk);
+		auto first = first_window * step_bases;
+		auto bases = std::min(size, (last_window - 1) * step_bases + window_bases) - first;
+
+		auto masks = detail::profile_masks(lhs, rhs, frame, map, first, bases);
+		std::vector<std::uint32_t> prefix(masks.size() + 1, 0);
+		for (std::size_t i = 0; i < masks.size(); ++i)
+			prefix[i + 1] = prefix[i] + static_cast<std::uint32_t>(mismatch_count(masks[i]));
+
+		auto before = [&](std::size_t offset)
+		{
+			auto index = offset / word_bases;
+			auto partial = offset % word_bases;
+			return prefix[index] + (partial ? static_cast<std::uint32_t>(mismatch_count(masks[index] & lead_mask(partial))) : 0);
+		};
+
+		for (auto w = first_window; w < last_window; ++w)
+		{
+			auto start = w * step_bases - first;
+			auto end = std::min(bases, start + window_bases);
+			emit(w * step_bases, static_cast<std::size_t>(before(end) - before(start)));
+		}
+	}
+}
+
+// A uint16 value per window and chromosome, counts saturating at 65535.
+// Chromosomes that can't be compared get no values.
+template<Person P>
+void write_divergence_track(const P& lhs, const P& rhs, std::ostream& os,
+		std::size_t window_bases = profile_window_bases, std::size_t step_bases = profile_step_bases,
+		std::size_t threads = default_threads())
+{
+	auto chromosomes = comparable_chromosomes(lhs, rhs);
+	std::vector<std::vector<std::uint16_t>> values(lhs.chromosomes());
+
+	parallel_for(chromosomes.size(), threads, [&](std::size_t i)
+	{
+		helix_of<P> lhs_helix = lhs.chromosome(chromosomes[i]);
+		helix_of<P> rhs_helix = rhs.chromosome(chromosomes[i]);
+		auto frame = frame_helices(lhs_helix, rhs_helix);
+		auto map = map_alignment(lhs_helix, rhs_helix, frame);
+
+		auto& track = values[chromosomes[i]];
+		divergence_profile(lhs_helix, rhs_helix, frame, map, [&](std::size_t, std::size_t mismatches)
+		{
+			track.push_back(static_cast<std::uint16_t>(std::min<std::size_t>(mismatches,
+					std::numeric_limits<std::uint16_t>::max())));
+		}, window_bases, step_bases);
+	});
+
+	os.write(track_magic.data(), track_magic.size());
+	write_le<std::uint64_t>(os, window_bases);
+	write_le<std::uint64_t>(os, step_bases);
+	write_le<std::uint64_t>(os, values.size());
+
+	auto offset = track_header_bytes + values.size() * track_directory_bytes;
+	for (const auto& track : values)
+	{
+		write_le<std::uint64_t>(os, offset);
+		write_le<std::uint64_t>(os, track.size());
+		offset += track.size() * 2;
+	}
+	for (const auto& track : values)
+		for (auto value : track)
+			write_le<std::uint16_t>(os, value);
+}
+
+template<Person P>
+void write_divergence_track(const P& lhs, const P& rhs, const std::string& path,
+		std::size_t window_bases = profile_window_bases, std::size_t step_bases = profile_step_bases,
+		std::size_t threads = default_threads())
+{
+	std::ofstream os(path, std::ios::binary | std::ios::trunc);
+	if (!os)
+		throw std::runtime_error("unable to create divergence track " + path);
+	write_divergence_track(lhs, rhs, os, window_bases, step_bases, threads);
+}
+
+class divergence_track
+{
+	mapped_file file_;
+	std::size_t window_;
+	std::size_t step_;
+	std::size_t chromosomes_;
+
+	const unsigned char* entry(std::size_t chromosome) const noexcept
+	{
+		return file_.data() + track_header_bytes + chromosome * track_directory_bytes;
+	}
+public:
+	explicit divergence_track(const std::string& path) :
+			file_(path),
+			window_(0),
+			step_(0),
+			chromosomes_(0)
+	{
+		if (file_.size() < track_header_bytes ||
+				!std::equal(track_magic.begin(), track_magic.end(), file_.data(),
+						[](char expected, unsigned char found) { return static_cast<unsigned char>(expected) == found; }))
+			throw std::runtime_error("not a divergence track " + path);
+
+		auto header = file_.data() + track_magic.size();
+		window_ = decode_le<std::uint64_t>(header);
+		step_ = decode_le<std::uint64_t>(header + 8);
+		chromosomes_ = decode_le<std::uint64_t>(header + 16);
+		if (chromosomes_ > (file_.size() - track_header_bytes) / track_directory_bytes)
+			throw std::runtime_error("corrupt divergence track " + path);
+
+		// Every track must lie after the directory and inside the file, so
+		// lookups need only check their indices against the header.
+		auto first = track_header_bytes + chromosomes_ * track_directory_bytes;
+		for (std::size_t chromosome = 0; chromosome < chromosomes_; ++chromosome)
+		{
+			auto offset = decode_le<std::uint64_t>(entry(chromosome));
+			auto windows = decode_le<std::uint64_t>(entry(chromosome) + 8);
+			if (offset < first || offset > file_.size() || windows > (file_.size() - offset) / 2)
+				throw std::runtime_error("corrupt divergence track " + path);
+		}
+	}
+
+	std::size_t window_bases() const noexcept
+	{
+		return window_;
+	}
+
+	std::size_t step_bases() const noexcept
+	{
+		return step_;
+	}
+
+	std::size_t chromosomes() const noexcept
+	{
+		return chromosomes_;
+	}
+
+	std::size_t windows(std::size_t chromosome) const
+	{
+		if (chromosome >= chromosomes_)
+			throw std::out_of_range("divergence track chromosome out of range");
+		return decode_le<std::uint64_t>(entry(chromosome) + 8);
+	}
+
+	std::uint16_t at(std::size_t chromosome, std::size_t window) const
+	{
+		if (window >= windows(chromosome))
+			throw std::out_of_range("divergence track window out of range");
+		return decode_le<std::uint16_t>(file_.data() + decode_le<std::uint64_t>(entry(chromosome)) + 2 * window);
+	}
+};
+
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <functional>
+#include <stdexcept>
+#include "packed_helix.hpp"
+#include "person_index.hpp"
+
+namespace dna
+{
+
+// Part of a chromosome, counted from the end of its head telomeres so the
+// same region can be located in anyone who kept enough of them.
+struct region
+{
+	std::size_t chromosome;
+	std::size_t start;
+	std::size_t length;
+};
+
+struct region_result
+{
+	bool located;
+	std::vector<difference> differences;
+};
+
+// A person together with the index stored beside their genome.
+template<Person P>
+struct indexed_person
+{
+	std::reference_wrapper<const P> person;
+	std::string index_path;
+};
+
+inline std::optional<std::size_t> region_origin(const telomere_bounds& bounds)
+{
+	if (!bounds.has_head())
+		return std::nullopt;
+	return bounds.head_end;
+}
+
+template<HelixStream S>
+std::optional<std::size_t> region_origin(S& helix)
+{
+	auto head = find_head_telomere(helix);
+	if (head.repeats < min_telomere_repeats)
+		return std::nullopt;
+	return head.length;
+}
+
+namespace detail
+{
+
+// origin_of(i, helix) locates the region start of target i. The region is
+// placed in each target at its telomere origin, re-anchored with seeds in
+// case an indel shifted it, and then mapped and compared like a whole pair
+// would be, with only the region and a resync margin around it in memory.
+template<Person P, typename Target, typename Origin>
+std::vector<region_result> compare_region(const P& query, std::optional<std::size_t> query_origin, const region& where,
+		std::size_t targets, Target&& target_at, Origin&& origin_of, std::size_t threads)
+{
+	if (!query_origin)
+		throw std::runtime_error("chromosome does not have enough telomere repeats to locate the region");
+
+	helix_of<P> query_helix = query.chromosome(where.chromosome);
+	auto query_start = *query_origin + where.start;
+	auto query_first = query_start - query_start % packed_size::value;
+	auto query_bases = load_packed(query_helix, query_first, query_start + where.length - query_first);
+	auto query_end = query_first + query_bases.size();
+	auto query_size = query_helix.size();
+	auto margin = resync_search_bases + resync_window_bases;
+
+	std::vector<region_result> results(targets, region_result{false, {}});
+	parallel_for(targets, threads, [&](std::size_t i)
+	{
+		const P& target = target_at(i);
+		if (where.chromosome == sex_chromosome_index && !same_sex_chromosome(query, target))
+			return;
+
+		helix_of<P> target_helix = target.chromosome(where.chromosome);
+		auto target_origin = origin_of(i, target_helix);
+		if (!target_origin)
+			return;
+
+		auto offset = static_cast<long>(*target_origin) - static_cast<long>(*query_origin);
+		auto expected = static_cast<std::size_t>(static_cast<long>(query_start) + offset);
+		auto target_first = expected > margin ? expected - margin : 0;
+		target_first -= target_first % packed_size::value;
+		auto target_bases = load_packed(target_helix, target_first, expected + where.length + margin - target_first);
+		auto target_end = target_first + target_bases.size();
+
+		packed_helix lhs(query_bases, query_first, query_size);
+		packed_helix rhs(target_bases, target_first, target_helix.size());
+		if (auto next = detail::resync_offset(lhs, rhs, query_start, offset, target_end))
+			offset = *next;
+		if (static_cast<long>(query_start) + offset < 0)
+			return;
+
+		alignment_frame frame{query_start, static_cast<std::size_t>(static_cast<long>(query_start) + offset),
+				query_end, target_end};
+		auto map = map_alignment(lhs, rhs, frame);
+
+		auto& result = results[i];
+		result.located = true;
+		compare_mapped(lhs, rhs, where.chromosome, map,
+				[&](const difference& found) { result.differences.push_back(found); });
+	});
+
+	return results;
+}
+
+}
+
+// Compares one region of `query` with the same region of every target. The
+// query side is located, read and packed once; its words are then shared by
+// all the targets, which are aligned to it and streamed in parallel, so an
+// indel between the telomeres and the region doesn't shift the comparison.
+// Targets that can't be located (too few telomeres, or the other sex
+// chromosome) come back with `located` unset. Throws when the query itself
+// can't be located.
+template<Person P>
+std::vector<region_result> compare_region(const P& query, const region& where,
+		const std::vector<std::reference_wrapper<const P>>& targets, std::size_t threads = default_threads())
+{
+	helix_of<P> query_helix = query.chromosome(where.chromosome);
+
+	return detail::compare_region(query, region_origin(query_helix), where, targets.size(),
+			[&](std::size_t i) -> const P& { return targets[i].get(); },
+			[](std::size_t, helix_of<P>& helix) { return region_origin(helix); },
+			threads);
+}
+
+// Same as above, but every region start comes from the stored person indexes
+// instead of rescanning telomeres.
+template<Person P>
+std::vector<region_result> compare_region(const indexed_person<P>& query, const region& where,
+		const std::vector<indexed_person<P>>& targets, std::size_t threads = default_threads())
+{
+	auto query_bounds = read_index_entry(query.index_path, where.chromosome);
+
+	return detail::compare_region(query.person.get(), region_origin(query_bounds), where, targets.size(),
+			[&](std::size_t i) -> const P& { return targets[i].person.get(); },
+			[&](std::size_t i, helix_of<P>&) { return region_origin(read_index_entry(targets[i].index_path, where.chromosome)); },
+			threads);
+}
+
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <memory>
+#include "engine.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t default_region_gap = 100;
+
+// Bits of difference_region::flags.
+static constexpr std::uint8_t region_has_insertion = 1;
+static constexpr std::uint8_t region_has_deletion = 2;
+static constexpr std::uint8_t region_has_inversion = 4;
+
+// A cluster of differences on the lhs: [start, end) covers every difference
+// in it, `mismatches` counts their bases. A region made only of insertions
+// has end == start.
+struct difference_region
+{
+	std::uint32_t start;
+	std::uint32_t end;
+	std::uint32_t mismatches;
+	std::uint8_t chromosome;
+	std::uint8_t flags;
+
+	constexpr bool has_insertion() const noexcept
+	{
+		return flags & region_has_insertion;
+	}
+
+	constexpr bool has_deletion() const noexcept
+	{
+		return flags & region_has_deletion;
+	}
+
+	constexpr bool has_inversion() const noexcept
+	{
+		return flags & region_has_inversion;
+	}
+};
+
+static_assert(sizeof(difference_region) == 16, "regions are meant to stay packed");
+
+constexpr bool operator==(const difference_region& lhs, const difference_region& rhs) noexcept
+{
+	return lhs.start == rhs.start && lhs.end == rhs.end && lhs.mismatches == rhs.mismatches &&
+			lhs.chromosome == rhs.chromosome && lhs.flags == rhs.flags;
+}
+
+// Fixed-size pages of regions; records never move once written.
+class region_arena
+{
+	static constexpr std::size_t page_regions = 4096;
+
+	std::vector<std::unique_ptr<difference_region[]>> pages_;
+	std::size_t size_;
+public:
+	region_arena() :
+			pages_(),
+			size_(0)
+	{ }
+
+	std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	bool empty() const noexcept
+	{
+		return size_ == 0;
+	}
+
+	std::size_t bytes() const noexcept
+	{
+		return pages_.size() * page_regions * sizeof(difference_region);
+	}
+
+	const difference_region& operator[](std::size_t index) const noexcept
+	{
+		return pages_[index / page_regions][index % page_regions];
+	}
+
+	void push_back(const difference_region& value)
+	{
+		if (size_ == pages_.size() * page_regions)
+			pages_.push_back(std::make_unique<difference_region[]>(page_regions));
+		pages_[size_ / page_regions][size_ % page_regions] = value;
+		++size_;
+	}
+
+	void append(const region_arena& other)
+	{
+		for (std::size_t i = 0; i < other.size(); ++i)
+			push_back(other[i]);
+	}
+};
+
+namespace detail
+{
+
+constexpr std::uint8_t region_flag(difference_kind kind) noexcept
+{
+	switch (kind)
+	{
+		case difference_kind::insertion:
+			return region_has_insertion;
+		case difference_kind::deletion:
+			return region_has_deletion;
+		case difference_kind::inversion:
+			return region_has_inversion;
+		default:
+			return 0;
+	}
+}
+
+}
+
+// Engine sink: differences of one chromosome arrive in order and are folded
+// into the open region while they start within `gap` bases of its end.
+class region_merger
+{
+	region_arena& arena_;
+	std::size_t gap_;
+	std::optional<difference_region> open_;
+public:
+	explicit region_merger(region_arena& arena, std::size_t gap = default_region_gap) :
+			arena_(arena),
+			gap_(gap),
+			open_()
+	{ }
+
+	void operator()(const difference& found)
+	{
+		auto flags = detail::region_flag(found.kind);
+
+		if (open_ && open_->chromosome == found.chromosome && found.start <= open_->end + gap_)
+		{
+			open_->end = std::max(open_->end, static_cast<std::uint32_t>(found.end()));
+			open_->mismatches += static_cast<std::uint32_t>(found.length);
+			open_->flags |= flags;
+			return;
+		}
+
+		flush();
+		open_ = difference_region{static_cast<std::uint32_t>(found.start), static_cast<std::uint32_t>(found.end()),
+				static_cast<std::uint32_t>(found.length), static_cast<std::uint8_t>(found.chromosome), flags};
+	}
+
+	void flush()
+	{
+		if (open_)
+			arena_.push_back(*open_);
+		open_.reset();
+	}
+};
+
+template<Person P>
+region_arena compare_regions(const P& lhs, const P& rhs, std::size_t gap = default_region_gap,
+		std::size_t threads = default_threads())
+{
+	auto chromosomes = comparable_chromosomes(lhs, rhs);
+	std::vector<region_arena> found(chromosomes.size());
+
+	parallel_for(chromosomes.size(), threads, [&](std::size_t i)
+	{
+		helix_of<P> lhs_helix = lhs.chromosome(chromosomes[i]);
+		helix_of<P> rhs_helix = rhs.chromosome(chromosomes[i]);
+		auto map = map_alignment(lhs_helix, rhs_helix, frame_helices(lhs_helix, rhs_helix));
+
+		region_merger merger(found[i], gap);
+		compare_mapped(lhs_helix, rhs_helix, chromosomes[i], map, merger);
+		merger.flush();
+	});
+
+	region_arena result;
+	for (const auto& part : found)
+		result.append(part);
+	return result;
+}
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cmath>
+#include <optional>
+#include <random>
+#include "engine.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t sample_windows = 2048;
+static constexpr std::size_t sample_window_bases = 512;
+
+struct divergence_estimate
+{
+	double rate;
+	double lower;
+	double upper;
+	std::size_t windows;
+	std::size_t sampled_bases;
+	std::size_t mismatches;
+};
+
+namespace detail
+{
+
+// Wilson score interval. Windows are clusters of neighbouring bases, so the
+// sample size is shrunk by the design effect whenever mismatches bunch up
+// more than independent bases would.
+inline divergence_estimate summarize_samples(const std::vector<std::size_t>& counts, std::size_t window_bases,
+		double z)
+{
+	auto windows = counts.size();
+	auto bases = windows * window_bases;
+	std::size_t mismatches = 0;
+	for (auto count : counts)
+		mismatches += count;
+
+	if (bases == 0)
+		return divergence_estimate{0.0, 0.0, 1.0, 0, 0, 0};
+
+	auto rate = static_cast<double>(mismatches) / static_cast<double>(bases);
+	auto effective = static_cast<double>(bases);
+	if (windows > 1 && mismatches > 0 && mismatches < bases)
+	{
+		double spread = 0;
+		for (auto count : counts)
+		{
+			auto delta = static_cast<double>(count) / static_cast<double>(window_bases) - rate;
+			spread += delta * delta;
+		}
+		auto clustered = spread / static_cast<double>(windows - 1) / static_cast<double>(windows);
+		auto independent = rate * (1 - rate) / static_cast<double>(bases);
+		effective /= std::max(1.0, clustered / independent);
+	}
+
+	auto z2 = z * z;
+	auto center = (rate + z2 / (2 * effective)) / (1 + z2 / effective);
+	auto half = z / (1 + z2 / effective) * std::sqrt(rate * (1 - rate) / effective + z2 / (4 * effective * effective));
+	return divergence_estimate{rate, std::max(0.0, center - half), std::min(1.0, center + half), windows, bases,
+			mismatches};
+}
+
+}
+
+// Compares `windows` short windows at random aligned positions, visited in
+// order so the offset learned after an indel carries over to later windows.
+// Only the sampled windows (and, after an indel, one anchor search) are read.
+// The estimate's `windows` counts the windows that were actually compared.
+template<HelixStream S>
+divergence_estimate estimate_divergence(S& lhs, S& rhs, const alignment_frame& frame,
+		std::size_t windows = sample_windows, std::size_t window_bases = sample_window_bases,
+		std::uint64_t seed = 0, double z = 1.96)
+{
+	if (frame.lhs_end < frame.lhs_begin + window_bases)
+		return detail::summarize_samples({}, window_bases, z);
+
+	std::mt19937_64 random(seed);
+	std::uniform_int_distribution<std::size_t> pick(frame.lhs_begin, frame.lhs_end - window_bases);
+	std::vector<std::size_t> positions(windows);
+	for (auto& position : positions)
+		position = pick(random);
+	std::sort(positions.begin(), positions.end());
+
+	// Windows that fall off either end of rhs have nothing to compare with;
+	// they are skipped so they don't count as fully divergent samples.
+	auto offset = frame.offset();
+	auto compare_at = [&](const packed_sequence& window, std::size_t position, long at) -> std::optional<std::size_t>
+	{
+		auto first = static_cast<long>(position) + at;
+		if (first < 0 || static_cast<std::size_t>(first) + window_bases > frame.rhs_end)
+			return std::nullopt;
+		auto other = load_packed(rhs, static_cast<std::size_t>(first), window_bases);
+		return count_mismatches(window, 0, other, 0, window_bases);
+	};
+
+	std::vector<std::size_t> counts;
+	counts.reserve(windows);
+	for (auto position : positions)
+	{
+		auto window = load_packed(lhs, position, window_bases);
+		auto count = compare_at(window, position, offset);
+
+		if (!count || *count >= desync_mismatches * window_bases / word_bases / 2)
+		{
+			auto moved = detail::resync_offset(lhs, rhs, position, offset, frame.rhs_end);
+			auto recount = moved ? compare_at(window, position, *moved) : std::nullopt;
+			if (recount && (!count || *recount < *count))
+			{
+				offset = *moved;
+				count = recount;
+			}
+		}
+
+		if (count)
+			counts.push_back(*count);
+	}
+
+	return detail::summarize_samples(counts, window_bases, z);
+}
+
+template<Person P>
+divergence_estimate estimate_divergence(const P& lhs, const P& rhs, std::size_t chromosome,
+		std::size_t windows = sample_windows, std::uint64_t seed = 0)
+{
+	helix_of<P> lhs_helix = lhs.chromosome(chromosome);
+	helix_of<P> rhs_helix = rhs.chromosome(chromosome);
+	auto frame = frame_helices(lhs_helix, rhs_helix);
+	return estimate_divergence(lhs_helix, rhs_helix, frame, windows, sample_window_bases, seed);
+}
+
+}
@@ -1,15 +1,18 @@
 #pragma once
 
+#include <concepts>
 #include <cstddef>
+#include <iterator>
+#include <ostream>
 #include "base.hpp"
 
 namespace dna
 {
 
 template<typename T>
-concept bool ByteBuffer = requires(T a) {
-	{ static_cast<std::size_t>(a.size()) } -> std::size_t;
-	{ a[0] } -> std::byte;
+concept ByteBuffer = requires(T a) {
+	{ static_cast<std::size_t>(a.size()) };
+	{ a[0] } -> std::convertible_to<std::byte>;
 };
 
 template<ByteBuffer T>
@@ -166,7 +169,7 @@ public:
 
 	constexpr T& buffer() noexcept
 	{
-		buffer_;
+		return buffer_;
 	}
 };
 
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "packed_sequence.hpp"
+
+namespace dna
+{
+
+enum class sex_chromosome
+{
+	x,
+	y
+};
+
+static constexpr std::size_t sex_chromosome_index = 22;
+
+static constexpr std::size_t x_chromosome_bases = 156000000;
+static constexpr std::size_t y_chromosome_bases = 57000000;
+
+// X and Y are far enough apart in length that the midpoint splits them
+// reliably, so the stream is never opened or read.
+template<HelixStream S>
+constexpr sex_chromosome classify_sex_chromosome(const S& helix)
+{
+	constexpr auto threshold = (x_chromosome_bases + y_chromosome_bases) / 2;
+	return helix_size(helix) >= threshold ? sex_chromosome::x : sex_chromosome::y;
+}
+
+template<Person P>
+bool same_sex_chromosome(const P& lhs, const P& rhs)
+{
+	return classify_sex_chromosome(lhs.chromosome(sex_chromosome_index)) ==
+			classify_sex_chromosome(rhs.chromosome(sex_chromosome_index));
+}
+
+}
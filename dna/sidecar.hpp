@@ -0,0 +1,206 @@
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <ranges>
+#include <string>
+#include "binary_io.hpp"
+#include "coarse.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+
+namespace dna
+{
+
+static constexpr std::array<char, 8> sidecar_magic = {'D', 'N', 'A', 'B', 'L', 'K', '0', '3'};
+static constexpr std::size_t sidecar_header_bytes = sidecar_magic.size() + 2 * 8;
+static constexpr std::size_t sidecar_record_bytes = 8 + 8 + 4 * 4;
+
+// Number of A, C, G and T in a block, indexed by base.
+using base_counts = std::array<std::uint32_t, 4>;
+
+inline std::string sidecar_path_for(const std::string& genome_path, std::size_t chromosome)
+{
+	return genome_path + "." + std::to_string(chromosome) + ".dnablk";
+}
+
+inline base_counts count_bases(const packed_sequence& bases) noexcept
+{
+	base_counts counts{};
+	for (std::size_t i = 0; i < bases.size(); i += word_bases)
+	{
+		auto word = bases.word(i);
+		auto high = (word >> 1) & low_bits;
+		auto low = word & low_bits;
+		counts[1] += static_cast<std::uint32_t>(__builtin_popcountll(low & ~high));
+		counts[2] += static_cast<std::uint32_t>(__builtin_popcountll(high & ~low));
+		counts[3] += static_cast<std::uint32_t>(__builtin_popcountll(high & low));
+	}
+	counts[0] = static_cast<std::uint32_t>(bases.size()) - counts[1] - counts[2] - counts[3];
+	return counts;
+}
+
+// One record per content-defined block of a helix, as block_scanner cuts
+// it: its first base, digest and composition. Blocks cover the helix from
+// base 0 and need no frame origin, since two people's blocks line up by
+// content whatever their telomere lengths. Written once at ingestion, read
+// back through a read-only mapping. Files from earlier versions, laid on a
+// fixed grid, are rejected and must be rewritten.
+template<HelixStream S>
+void write_block_sidecar(S& helix, std::ostream& os, std::size_t block_bases = digest_block_bases)
+{
+	os.write(sidecar_magic.data(), sidecar_magic.size());
+	write_le<std::uint64_t>(os, block_bases);
+	write_le<std::uint64_t>(os, helix_size(helix));
+
+	block_scanner<S&> scanner(helix, block_bases);
+	while (auto block = scanner.next())
+	{
+		write_le<std::uint64_t>(os, block->first);
+		write_le<std::uint64_t>(os, block_digest(block->bases));
+		for (auto count : count_bases(block->bases))
+			write_le<std::uint32_t>(os, count);
+	}
+}
+
+template<HelixStream S>
+void write_block_sidecar(S& helix, const std::string& path, std::size_t block_bases = digest_block_bases)
+{
+	std::ofstream os(path, std::ios::binary | std::ios::trunc);
+	if (!os)
+		throw std::runtime_error("unable to create block sidecar " + path);
+	write_block_sidecar(helix, os, block_bases);
+}
+
+template<Person P>
+void write_person_sidecars(const P& person, const std::string& genome_path, std::size_t threads = default_threads(),
+		std::size_t block_bases = digest_block_bases)
+{
+	parallel_for(person.chromosomes(), threads, [&](std::size_t i)
+	{
+		auto helix = person.chromosome(i);
+		write_block_sidecar(helix, sidecar_path_for(genome_path, i), block_bases);
+	});
+}
+
+// Stored digests of one helix, usable by compare_coarse as they are.
+class block_sidecar
+{
+	mapped_file file_;
+	std::size_t block_bases_;
+	std::size_t bases_;
+	std::size_t blocks_;
+
+	const unsigned char* record(std::size_t block) const noexcept
+	{
+		return file_.data() + sidecar_header_bytes + block * sidecar_record_bytes;
+	}
+public:
+	explicit block_sidecar(const std::string& path) :
+			file_(path),
+			block_bases_(0),
+			bases_(0),
+			blocks_(0)
+	{
+		if (file_.size() < sidecar_header_bytes ||
+				!std::equal(sidecar_magic.begin(), sidecar_magic.end(), file_.data(),
+						[](char expected, unsigned char found) { return static_cast<unsigned char>(expected) == found; }))
+			throw std::runtime_error("not a block sidecar " + path);
+
+		auto header = file_.data() + sidecar_magic.size();
+		block_bases_ = decode_le<std::uint64_t>(header);
+		bases_ = decode_le<std::uint64_t>(header + 8);
+		blocks_ = (file_.size() - sidecar_header_bytes) / sidecar_record_bytes;
+
+		if (block_bases_ == 0 || (file_.size() - sidecar_header_bytes) % sidecar_record_bytes != 0 ||
+				(blocks_ == 0) != (bases_ == 0))
+			throw std::runtime_error("corrupt block sidecar " + path);
+
+		// Lookups binary search the first bases, so they must rise from 0
+		// and stay inside the helix.
+		if (blocks_ > 0 && (first(0) != 0 || first(blocks_ - 1) >= bases_))
+			throw std::runtime_error("corrupt block sidecar " + path);
+		for (std::size_t block = 1; block < blocks_; ++block)
+			if (first(block) <= first(block - 1))
+				throw std::runtime_error("corrupt block sidecar " + path);
+	}
+
+	std::size_t block_bases() const noexcept
+	{
+		return block_bases_;
+	}
+
+	std::size_t bases() const noexcept
+	{
+		return bases_;
+	}
+
+	std::size_t blocks() const noexcept
+	{
+		return blocks_;
+	}
+
+	std::size_t first(std::size_t block) const noexcept
+	{
+		return decode_le<std::uint64_t>(record(block));
+	}
+
+	std::size_t count(std::size_t block) const noexcept
+	{
+		return (block + 1 < blocks_ ? first(block + 1) : bases_) - first(block);
+	}
+
+	std::uint64_t digest(std::size_t block) const noexcept
+	{
+		return decode_le<std::uint64_t>(record(block) + 8);
+	}
+
+	base_counts composition(std::size_t block) const noexcept
+	{
+		auto counts = record(block) + 16;
+		return base_counts{decode_le<std::uint32_t>(counts), decode_le<std::uint32_t>(counts + 4),
+				decode_le<std::uint32_t>(counts + 8), decode_le<std::uint32_t>(counts + 12)};
+	}
+
+	std::optional<digest_block> block_at(std::size_t position) const
+	{
+		if (position >= bases_)
+			return std::nullopt;
+
+		auto indexes = std::views::iota(std::size_t{0}, blocks_);
+		auto after = std::ranges::partition_point(indexes, [&](std::size_t block) { return first(block) <= position; });
+		auto block = static_cast<std::size_t>(after - indexes.begin()) - 1;
+		return digest_block{first(block), count(block), digest(block)};
+	}
+};
+
+struct sidecar_check
+{
+	bool size_matches;
+	std::vector<std::size_t> bad_blocks;
+
+	bool ok() const noexcept
+	{
+		return size_matches && bad_blocks.empty();
+	}
+};
+
+// Rehashes every stored block from the helix and lists the ones that
+// disagree.
+template<HelixStream S>
+sidecar_check verify_block_sidecar(S& helix, const block_sidecar& sidecar)
+{
+	sidecar_check check{helix_size(helix) == sidecar.bases(), {}};
+	if (!check.size_matches)
+		return check;
+
+	for (std::size_t block = 0; block < sidecar.blocks(); ++block)
+	{
+		auto window = load_packed(helix, sidecar.first(block), sidecar.count(block));
+		if (block_digest(window) != sidecar.digest(block) || count_bases(window) != sidecar.composition(block))
+			check.bad_blocks.push_back(block);
+	}
+	return check;
+}
+
+}
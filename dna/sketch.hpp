@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "kernel.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t sketch_kmer_bases = 21;
+static constexpr std::size_t sketch_hashes = 1024;
+
+// Bottom-k MinHash sketch: the smallest distinct hashes of all canonical
+// k-mers of a helix, kept in ascending order.
+struct minhash_sketch
+{
+	std::vector<std::uint64_t> hashes;
+};
+
+inline bool operator==(const minhash_sketch& lhs, const minhash_sketch& rhs) noexcept
+{
+	return lhs.hashes == rhs.hashes;
+}
+
+class sketch_builder
+{
+	static constexpr std::uint64_t kmer_mask = (std::uint64_t{1} << (2 * sketch_kmer_bases)) - 1;
+
+	std::size_t limit_;
+	std::vector<std::uint64_t> kept_;
+	std::vector<std::uint64_t> pending_;
+	std::uint64_t bound_;
+	std::uint64_t forward_;
+	std::uint64_t reverse_;
+	std::size_t filled_;
+
+	void merge()
+	{
+		kept_.insert(kept_.end(), pending_.begin(), pending_.end());
+		pending_.clear();
+		std::sort(kept_.begin(), kept_.end());
+		kept_.erase(std::unique(kept_.begin(), kept_.end()), kept_.end());
+		if (kept_.size() >= limit_)
+		{
+			kept_.resize(limit_);
+			bound_ = kept_.back();
+		}
+	}
+public:
+	explicit sketch_builder(std::size_t hashes = sketch_hashes) :
+			limit_(hashes),
+			kept_(),
+			pending_(),
+			bound_(~std::uint64_t{0}),
+			forward_(0),
+			reverse_(0),
+			filled_(0)
+	{
+		if (limit_ == 0)
+			throw std::invalid_argument("a sketch needs at least one hash");
+		kept_.reserve(2 * limit_);
+		pending_.reserve(4 * limit_);
+	}
+
+	void push(base value)
+	{
+		auto code = static_cast<std::uint64_t>(value);
+		forward_ = ((forward_ << 2) | code) & kmer_mask;
+		reverse_ = (reverse_ >> 2) | ((code ^ 0x3) << (2 * (sketch_kmer_bases - 1)));
+		if (++filled_ < sketch_kmer_bases)
+			return;
+
+		auto hash = mix_bits(std::min(forward_, reverse_));
+		if (hash > bound_)
+			return;
+
+		pending_.push_back(hash);
+		if (pending_.size() == pending_.capacity())
+			merge();
+	}
+
+	void push(std::byte packed)
+	{
+		for (auto value : unpack(packed))
+			push(value);
+	}
+
+	// Starts a new sequence: k-mers never span the break.
+	void restart() noexcept
+	{
+		filled_ = 0;
+	}
+
+	minhash_sketch finish() &&
+	{
+		merge();
+		return minhash_sketch{std::move(kept_)};
+	}
+};
+
+// One sequential pass over the whole helix.
+template<HelixStream S>
+minhash_sketch sketch_helix(S& helix, std::size_t hashes = sketch_hashes)
+{
+	sketch_builder builder(hashes);
+	helix.seek(0);
+
+	for (;;)
+	{
+		const auto chunk = helix.read();
+		const auto& bytes = chunk.buffer();
+		if (bytes.size() == 0)
+			break;
+		for (auto packed : bytes)
+			builder.push(packed);
+	}
+
+	return std::move(builder).finish();
+}
+
+// Estimates the Jaccard similarity of the two k-mer sets from the bottom of
+// their union: the share of those hashes that both sketches hold.
+inline double jaccard_estimate(const minhash_sketch& lhs, const minhash_sketch& rhs) noexcept
+{
+	auto limit = std::min(lhs.hashes.size(), rhs.hashes.size());
+	if (limit == 0)
+		return lhs.hashes.empty() && rhs.hashes.empty() ? 1.0 : 0.0;
+
+	auto l = lhs.hashes.begin();
+	auto r = rhs.hashes.begin();
+	std::size_t seen = 0;
+	std::size_t shared = 0;
+
+	while (seen < limit && l != lhs.hashes.end() && r != rhs.hashes.end())
+	{
+		if (*l == *r)
+		{
+			++shared;
+			++l;
+			++r;
+		}
+		else if (*l < *r)
+			++l;
+		else
+			++r;
+		++seen;
+	}
+
+	return static_cast<double>(shared) / static_cast<double>(seen);
+}
+
+}
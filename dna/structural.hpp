@@ -0,0 +1,181 @@
+#pragma once
+
+#include "engine.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t sv_window_bases = std::size_t{1} << 12;
+static constexpr std::size_t sv_search_bases = std::size_t{1} << 20;
+
+struct structural_break
+{
+	difference variant;
+	sync_jump jump;
+};
+
+namespace detail
+{
+
+inline std::optional<long> inverted_diagonal(const packed_sequence& lhs, std::size_t lhs_origin, const kmer_index& rhs,
+		std::size_t stride)
+{
+	std::unordered_map<long, std::size_t> votes;
+	for (std::size_t i = 0; i + word_bases <= lhs.size(); i += stride)
+	{
+		if (auto position = rhs.find(reverse_complement(lhs.word(i))))
+			++votes[static_cast<long>(lhs_origin + i + *position + word_bases - 1)];
+	}
+
+	std::optional<anchor_offset> best;
+	for (const auto& vote : votes)
+	{
+		if (vote.second >= min_anchor_support && (!best || vote.second > best->support))
+			best = anchor_offset{vote.first, vote.second};
+	}
+	if (!best)
+		return std::nullopt;
+	return best->offset;
+}
+
+// Inside an inversion lhs x pairs with rhs `diagonal - x` on the other
+// strand. The start is the leftmost split near `lost` that leaves the fewest
+// mismatches with forward pairing before it and inverted pairing after it.
+template<HelixStream S>
+std::size_t refine_inversion(S& lhs, S& rhs, std::size_t floor, std::size_t lost, long offset, long diagonal)
+{
+	auto from = std::max(floor, lost > 2 * word_bases ? lost - 2 * word_bases : 0);
+	auto to = lost + 2 * word_bases;
+	if (static_cast<long>(from) + offset < 0 || diagonal - static_cast<long>(to) + 1 < 0)
+		return lost;
+
+	auto count = to - from;
+	auto lhs_window = load_packed(lhs, from, count);
+	auto forward = load_packed(rhs, static_cast<std::size_t>(static_cast<long>(from) + offset), count);
+	auto inverted = load_packed(rhs, static_cast<std::size_t>(diagonal - static_cast<long>(to) + 1), count);
+	if (inverted.size() < count)
+		return lost;
+	count = std::min(lhs_window.size(), forward.size());
+
+	std::vector<std::size_t> forward_prefix(count + 1, 0);
+	std::vector<std::size_t> inverted_suffix(count + 1, 0);
+	for (std::size_t i = 0; i < count; ++i)
+		forward_prefix[i + 1] = forward_prefix[i] + (lhs_window[i] != forward[i]);
+	for (auto i = count; i > 0; --i)
+		inverted_suffix[i - 1] = inverted_suffix[i] + (lhs_window[i - 1] != complement(inverted[to - from - i]));
+
+	std::size_t best = 0;
+	for (std::size_t t = 1; t <= count; ++t)
+	{
+		if (forward_prefix[t] + inverted_suffix[t] < forward_prefix[best] + inverted_suffix[best])
+			best = t;
+	}
+	return from + best;
+}
+
+}
+
+// Called where the local resync gave up. Seeds from just past the break are
+// looked up much further away: lhs seeds found later on the rhs mean an
+// insertion, rhs seeds found later on the lhs a deletion, and lhs seeds
+// found reverse complemented on the rhs an inversion.
+template<HelixStream S>
+std::optional<structural_break> find_structural_break(S& lhs, S& rhs, const alignment_frame& frame,
+		std::size_t chromosome, std::size_t floor, std::size_t lost, long offset)
+{
+	auto rhs_from = static_cast<long>(lost) + offset;
+	if (rhs_from < 0 || static_cast<std::size_t>(rhs_from) >= frame.rhs_end)
+		return std::nullopt;
+
+	auto rhs_start = static_cast<std::size_t>(rhs_from);
+	auto lhs_window = load_packed(lhs, lost, sv_window_bases);
+	auto rhs_span = load_packed(rhs, rhs_start, std::min(frame.rhs_end - rhs_start, sv_search_bases + sv_window_bases));
+	kmer_index rhs_index(rhs_span, rhs_start);
+
+	auto forward = find_anchor_offset(lhs_window, lost, rhs_index, resync_stride);
+	if (forward && forward->offset > offset)
+	{
+		auto next = forward->offset;
+		auto split = detail::refine_breakpoint(lhs, rhs, floor, lost, offset, next);
+		split = detail::normalize_breakpoint(lhs, rhs, floor, split, offset, next);
+		auto length = static_cast<std::size_t>(next - offset);
+		auto other = static_cast<std::size_t>(static_cast<long>(split) + offset);
+		auto alternate = load_packed(rhs, other, std::min(length, word_bases)).word(0);
+		return structural_break{difference{chromosome, split, length, other, difference_kind::insertion, alternate},
+				sync_jump{split, split, next}};
+	}
+
+	auto rhs_window = load_packed(rhs, rhs_start, sv_window_bases);
+	auto lhs_span = load_packed(lhs, lost, std::min(frame.lhs_end - std::min(lost, frame.lhs_end),
+			sv_search_bases + sv_window_bases));
+	auto backward = find_anchor_offset(rhs_window, rhs_start, kmer_index(lhs_span, lost), resync_stride);
+	if (backward && -backward->offset < offset)
+	{
+		auto next = -backward->offset;
+		auto split = detail::refine_breakpoint(lhs, rhs, floor, lost, offset, next);
+		split = detail::normalize_breakpoint(lhs, rhs, floor, split, offset, next);
+		auto length = static_cast<std::size_t>(offset - next);
+		auto other = static_cast<std::size_t>(static_cast<long>(split) + offset);
+		return structural_break{difference{chromosome, split, length, other, difference_kind::deletion, 0},
+				sync_jump{split, split + length, next}};
+	}
+
+	auto diagonal = detail::inverted_diagonal(lhs_window, lost, rhs_index, resync_stride);
+	if (!diagonal)
+		return std::nullopt;
+
+	auto start = detail::refine_inversion(lhs, rhs, floor, lost, offset, *diagonal);
+	auto end = *diagonal - offset - static_cast<long>(start) + 1;
+	if (end <= static_cast<long>(start))
+		return std::nullopt;
+
+	auto length = static_cast<std::size_t>(end) - start;
+	return structural_break{difference{chromosome, start, length, static_cast<std::size_t>(static_cast<long>(start) + offset),
+			difference_kind::inversion, 0}, sync_jump{start, start + length, offset}};
+}
+
+// The pairwise engine with a structural pass wherever it loses the offset
+// for good. Large insertions and deletions come out of the alignment map as
+// usual; inversions are reported as one record in place of the
+// substitutions the base compare finds inside them.
+template<HelixStream S, typename F>
+void compare_structural(S& lhs, S& rhs, std::size_t chromosome, const alignment_frame& frame, F&& emit)
+{
+	std::vector<difference> inversions;
+	auto map = map_alignment(lhs, rhs, frame, map_block_bases,
+			[&](std::size_t floor, std::size_t lost, long offset) -> std::optional<sync_jump>
+			{
+				auto found = find_structural_break(lhs, rhs, frame, chromosome, floor, lost, offset);
+				if (!found)
+					return std::nullopt;
+				if (found->variant.kind == difference_kind::inversion)
+					inversions.push_back(found->variant);
+				return found->jump;
+			});
+
+	auto next = inversions.begin();
+	compare_mapped(lhs, rhs, chromosome, map, [&](const difference& found)
+	{
+		for (; next != inversions.end() && next->start <= found.start; ++next)
+			emit(*next);
+		if (next != inversions.begin() && found.start < std::prev(next)->end())
+			return;
+		emit(found);
+	});
+	for (; next != inversions.end(); ++next)
+		emit(*next);
+}
+
+template<Person P>
+std::vector<difference> compare_chromosome_structural(const P& lhs, const P& rhs, std::size_t chromosome)
+{
+	helix_of<P> lhs_helix = lhs.chromosome(chromosome);
+	helix_of<P> rhs_helix = rhs.chromosome(chromosome);
+	auto frame = frame_helices(lhs_helix, rhs_helix);
+
+	std::vector<difference> result;
+	compare_structural(lhs_helix, rhs_helix, chromosome, frame, [&](const difference& found) { result.push_back(found); });
+	return result;
+}
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include "packed_sequence.hpp"
+
+namespace dna
+{
+
+static constexpr std::array<base, 6> telomere_motif = {T, T, A, G, G, G};
+static constexpr std::size_t telomere_scan_bases = std::size_t{1} << 14;
+static constexpr std::size_t min_telomere_repeats = 3;
+
+// Telomere runs at both ends of a helix. The head run ends right before
+// `head_end` and the tail run starts at `tail_begin`; repeat counts only
+// include complete motifs, not the pieces the sequencer chopped off.
+struct telomere_bounds
+{
+	std::size_t head_end;
+	std::size_t head_repeats;
+	std::size_t tail_begin;
+	std::size_t tail_repeats;
+	std::size_t size;
+
+	constexpr bool has_head() const noexcept
+	{
+		return head_repeats >= min_telomere_repeats;
+	}
+
+	constexpr bool has_tail() const noexcept
+	{
+		return tail_repeats >= min_telomere_repeats;
+	}
+};
+
+struct telomere_run
+{
+	std::size_t length;
+	std::size_t repeats;
+};
+
+namespace detail
+{
+
+inline telomere_run leading_telomere_run(const packed_sequence& window)
+{
+	constexpr auto period = telomere_motif.size();
+
+	telomere_run best{0, 0};
+	for (std::size_t phase = 0; phase < period; ++phase)
+	{
+		std::size_t length = 0;
+		while (length < window.size() && window[length] == telomere_motif[(phase + length) % period])
+			++length;
+
+		if (length > best.length)
+		{
+			auto first = (period - phase) % period;
+			best = telomere_run{length, length >= first ? (length - first) / period : 0};
+		}
+	}
+	return best;
+}
+
+inline telomere_run trailing_telomere_run(const packed_sequence& window)
+{
+	constexpr auto period = telomere_motif.size();
+	auto n = window.size();
+
+	telomere_run best{0, 0};
+	for (std::size_t phase = 0; phase < period; ++phase)
+	{
+		std::size_t length = 0;
+		while (length < n && window[n - 1 - length] == telomere_motif[(phase + period - length % period) % period])
+			++length;
+
+		if (length > best.length)
+		{
+			auto partial = (phase + 1) % period;
+			best = telomere_run{length, length >= partial ? (length - partial) / period : 0};
+		}
+	}
+	return best;
+}
+
+}
+
+template<HelixStream S>
+telomere_run find_head_telomere(S& helix)
+{
+	auto total = helix_size(helix);
+
+	telomere_run head{0, 0};
+	for (auto scan = telomere_scan_bases; ; scan *= 2)
+	{
+		scan = std::min(scan, total);
+		head = detail::leading_telomere_run(load_packed(helix, 0, scan));
+		if (head.length < scan || scan == total)
+			return head;
+	}
+}
+
+// Scans both ends of a helix, reading a growing window from each end until
+// the repeats stop.
+template<HelixStream S>
+telomere_bounds find_telomeres(S& helix)
+{
+	auto total = helix_size(helix);
+	auto head = find_head_telomere(helix);
+
+	telomere_run tail{0, 0};
+	for (auto scan = telomere_scan_bases; ; scan *= 2)
+	{
+		scan = std::min(scan, total - head.length);
+		tail = detail::trailing_telomere_run(load_packed(helix, total - scan, scan));
+		if (tail.length < scan || scan == total - head.length)
+			break;
+	}
+
+	return telomere_bounds{head.length, head.repeats, total - tail.length, tail.repeats, total};
+}
+
+}
@@ -0,0 +1,62 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <alignment_map.hpp>
+
+namespace
+{
+
+std::vector<dna::difference> compare_mapped(fake_stream& lhs, fake_stream& rhs, dna::alignment_map& map)
+{
+	auto frame = dna::frame_helices(lhs, rhs);
+	map = dna::map_alignment(lhs, rhs, frame);
+
+	std::vector<dna::difference> found;
+	dna::compare_mapped(lhs, rhs, 0, map, [&](const dna::difference& d) { found.push_back(d); });
+	return found;
+}
+
+}
+
+TEST_CASE("Alignment resyncs after an insertion", "[alignment_map]")
+{
+	auto core = random_bases(40000, 30);
+	auto lhs_bases = telomeres(10) + core + telomeres(10);
+	auto rhs_bases = telomeres(10) + core.substr(0, 15000) + "ACGTTGCA" + core.substr(15000) + telomeres(10);
+	rhs_bases[60 + 30000] = rhs_bases[60 + 30000] == 'A' ? 'C' : 'A';
+
+	auto lhs = make_helix(lhs_bases, 256);
+	auto rhs = make_helix(rhs_bases, 256);
+	dna::alignment_map map;
+	auto found = compare_mapped(lhs, rhs, map);
+
+	REQUIRE(map.size() == 2);
+	REQUIRE(map[0].rhs - map[0].lhs == 0);
+	REQUIRE(map[1].rhs - map[1].lhs == 8);
+	REQUIRE(found.size() == 2);
+	REQUIRE(found[0].kind == dna::difference_kind::insertion);
+	REQUIRE(found[0].length == 8);
+	REQUIRE(found[0].start >= 60 + 14990);
+	REQUIRE(found[0].start <= 60 + 15000);
+	REQUIRE(found[1].kind == dna::difference_kind::substitution);
+	REQUIRE(found[1].other_start == 60 + 30000);
+}
+
+TEST_CASE("Alignment resyncs after a deletion", "[alignment_map]")
+{
+	auto core = random_bases(40000, 31);
+	auto lhs_bases = telomeres(10) + core + telomeres(10);
+	auto rhs_bases = telomeres(10) + core.substr(0, 20000) + core.substr(20300) + telomeres(10);
+
+	auto lhs = make_helix(lhs_bases, 256);
+	auto rhs = make_helix(rhs_bases, 256);
+	dna::alignment_map map;
+	auto found = compare_mapped(lhs, rhs, map);
+
+	REQUIRE(map.size() == 2);
+	REQUIRE(found.size() == 1);
+	REQUIRE(found[0].kind == dna::difference_kind::deletion);
+	REQUIRE(found[0].length == 300);
+	REQUIRE(found[0].start >= 60 + 19990);
+	REQUIRE(found[0].start <= 60 + 20000);
+	REQUIRE(map.back().lhs + map.back().length == 60 + 40000);
+}
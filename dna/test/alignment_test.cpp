@@ -0,0 +1,53 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <alignment.hpp>
+
+TEST_CASE("Telomeres are found on both ends, even when chopped", "[alignment]")
+{
+	auto core = random_bases(2000, 20);
+	auto helix = make_helix("GGG" + telomeres(40) + core + telomeres(25) + "TTA");
+
+	auto bounds = dna::find_telomeres(helix);
+	REQUIRE(bounds.has_head());
+	REQUIRE(bounds.has_tail());
+	REQUIRE(bounds.head_repeats == 40);
+	REQUIRE(bounds.tail_repeats == 25);
+	REQUIRE(bounds.head_end >= 3 + 240);
+	REQUIRE(bounds.head_end < 3 + 240 + 6);
+	REQUIRE(bounds.tail_begin <= 3 + 240 + 2000);
+}
+
+TEST_CASE("Helices line up on the end of their telomeres", "[alignment]")
+{
+	auto core = random_bases(3000, 21);
+	auto lhs = make_helix(telomeres(10) + core + telomeres(3));
+	auto rhs = make_helix("AGGG" + telomeres(30) + core + telomeres(12));
+
+	auto range = dna::align_helices(lhs, rhs);
+	REQUIRE(static_cast<long>(range.rhs) - static_cast<long>(range.lhs) == 4 + 20 * 6);
+	REQUIRE(dna::collect_differences(lhs, rhs, 0, range).empty());
+}
+
+TEST_CASE("Seed anchors align helices that lost their telomeres", "[alignment]")
+{
+	auto core = random_bases(20000, 22);
+	auto lhs_bases = telomeres(20) + core;
+	auto rhs_bases = core.substr(517);
+	rhs_bases[9000] = rhs_bases[9000] == 'A' ? 'G' : 'A';
+
+	auto lhs = make_helix(lhs_bases);
+	auto rhs = make_helix(rhs_bases);
+
+	auto anchor = dna::find_anchor_offset(lhs, 120, rhs, 0);
+	REQUIRE(anchor);
+	REQUIRE(anchor->offset == -(120 + 517));
+	REQUIRE(anchor->support >= dna::min_anchor_support);
+
+	auto range = dna::align_helices(lhs, rhs);
+	REQUIRE(range.lhs - range.rhs == 120 + 517);
+	REQUIRE(range.rhs < 6);
+
+	auto found = dna::collect_differences(lhs, rhs, 0, range);
+	REQUIRE(found.size() == 1);
+	REQUIRE(found[0].other_start == 9000);
+}
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <all_pairs.hpp>
+
+namespace
+{
+
+// Counts how often each chromosome is opened, which is when its bases are
+// read: once for the telomeres, then once per shared range or lane that
+// falls back to its own helix.
+class counting_person
+{
+	fake_person person_;
+	std::shared_ptr<std::array<std::atomic<std::size_t>, 23>> opened_;
+public:
+	explicit counting_person(fake_person person) :
+			person_(std::move(person)),
+			opened_(std::make_shared<std::array<std::atomic<std::size_t>, 23>>())
+	{ }
+
+	fake_stream chromosome(std::size_t chromosome_index) const
+	{
+		++(*opened_)[chromosome_index];
+		return person_.chromosome(chromosome_index);
+	}
+
+	constexpr std::size_t chromosomes() const
+	{
+		return 23;
+	}
+
+	std::size_t opened(std::size_t chromosome_index) const
+	{
+		return (*opened_)[chromosome_index];
+	}
+};
+
+}
+
+TEST_CASE("All-pairs tiles match pairwise comparisons", "[all_pairs]")
+{
+	std::vector<std::string> base;
+	for (unsigned i = 0; i < 23; ++i)
+		base.push_back(telomeres(8) + random_bases(3000, 80 + i) + telomeres(8));
+
+	std::vector<fake_person> people;
+	for (unsigned p = 0; p < 5; ++p)
+	{
+		auto genome = base;
+		genome[p][60 + 100 * p] = genome[p][60 + 100 * p] == 'A' ? 'G' : 'A';
+		genome[12][1000 + p] = genome[12][1000 + p] == 'A' ? 'G' : 'A';
+		if (p == 3)
+			genome[6] = telomeres(11) + base[6].substr(48, 1500) + "CCCA" + base[6].substr(48 + 1500);
+		people.push_back(make_person(genome));
+	}
+
+	std::vector<std::reference_wrapper<const fake_person>> cohort(people.begin(), people.end());
+	std::map<std::pair<std::size_t, std::size_t>, std::vector<dna::difference>> found;
+	std::mutex lock;
+
+	dna::pair_tiling tiling;
+	tiling.block_people = 2;
+	tiling.range_bases = 700;
+	tiling.margin_bases = 100;
+	tiling.threads = 4;
+
+	dna::compare_all_pairs(cohort, [&](std::size_t i, std::size_t j, const dna::difference& d)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		found[{i, j}].push_back(d);
+	}, tiling);
+
+	REQUIRE(found.size() == 10);
+	for (std::size_t i = 0; i < people.size(); ++i)
+	{
+		for (auto j = i + 1; j < people.size(); ++j)
+		{
+			INFO("pair " << i << ", " << j);
+			auto& pair = found[{i, j}];
+			std::stable_sort(pair.begin(), pair.end());
+			REQUIRE(pair == dna::compare_people(people[i], people[j]));
+		}
+	}
+}
+
+TEST_CASE("All-pairs reads each range once per person", "[all_pairs]")
+{
+	std::vector<std::string> base;
+	for (unsigned i = 0; i < 23; ++i)
+		base.push_back(telomeres(8) + random_bases(2800, 90 + i) + telomeres(8));
+
+	std::vector<counting_person> people;
+	for (unsigned p = 0; p < 7; ++p)
+	{
+		auto genome = base;
+		genome[4][200 + 10 * p] = genome[4][200 + 10 * p] == 'A' ? 'G' : 'A';
+		if (p == 2)
+			genome[9] = base[9].substr(0, 1200) + base[9].substr(1260);
+		people.emplace_back(make_person(genome));
+	}
+
+	std::vector<std::reference_wrapper<const counting_person>> cohort(people.begin(), people.end());
+	std::atomic<std::size_t> found{0};
+
+	dna::pair_tiling tiling;
+	tiling.block_people = 3;
+	tiling.range_bases = 700;
+	tiling.margin_bases = 100;
+	tiling.threads = 4;
+	dna::compare_all_pairs(cohort, [&](std::size_t, std::size_t, const dna::difference&) { ++found; }, tiling);
+
+	// 21 pairs with two SNPs each on chromosome 4, six with a deletion on 9.
+	REQUIRE(found == 21 * 2 + 6);
+
+	// Telomeres plus four ranges, however many pairs a person is in; only
+	// the deletion's pairs and the sex chromosome check open more.
+	for (const auto& person : people)
+	{
+		for (std::size_t chromosome = 0; chromosome < 22; ++chromosome)
+		{
+			if (chromosome != 9)
+				REQUIRE(person.opened(chromosome) == 5);
+		}
+	}
+}
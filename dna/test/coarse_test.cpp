@@ -0,0 +1,182 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <coarse.hpp>
+#include "counting_stream.hpp"
+
+namespace
+{
+
+// Blocks the scanner cuts from a helix.
+std::vector<dna::digest_block> blocks_of(fake_stream helix, std::size_t block_bases = dna::digest_block_bases)
+{
+	std::vector<dna::digest_block> blocks;
+	dna::block_scanner<fake_stream> scanner(std::move(helix), block_bases);
+	while (auto next = scanner.next())
+		blocks.push_back(dna::digest_block{next->first, next->bases.size(), dna::block_digest(next->bases)});
+	return blocks;
+}
+
+std::vector<dna::difference> coarse(fake_stream& lhs, fake_stream& rhs, std::size_t block)
+{
+	std::vector<dna::difference> found;
+	dna::compare_coarse(lhs, rhs, 0, dna::frame_helices(lhs, rhs),
+			[&](const dna::difference& d) { found.push_back(d); }, block);
+	return found;
+}
+
+std::vector<dna::difference> fine(fake_stream& lhs, fake_stream& rhs)
+{
+	std::vector<dna::difference> found;
+	auto map = dna::map_alignment(lhs, rhs, dna::frame_helices(lhs, rhs));
+	dna::compare_mapped(lhs, rhs, 0, map, [&](const dna::difference& d) { found.push_back(d); });
+	return found;
+}
+
+}
+
+TEST_CASE("Block digests depend only on the bases", "[coarse]")
+{
+	auto bases = random_bases(3000, 130);
+	auto shifted = "ACG" + bases;
+	auto lhs = make_helix(bases);
+	auto rhs = make_helix(shifted);
+
+	auto left = dna::load_packed(lhs, 100, 2000);
+	auto right = dna::load_packed(rhs, 103, 2000);
+	REQUIRE(dna::block_digest(left) == dna::block_digest(right));
+	REQUIRE(dna::block_digest(left) != dna::block_digest(dna::load_packed(lhs, 101, 2000)));
+}
+
+TEST_CASE("Coarse compare matches the base level engine", "[coarse]")
+{
+	auto core = random_bases(60000, 131);
+	auto other = core;
+	other[5000] = other[5000] == 'A' ? 'C' : 'A';
+	other[41000] = other[41000] == 'A' ? 'C' : 'A';
+	other = other.substr(0, 20000) + "GATTACA" + other.substr(20000);
+
+	auto lhs = make_helix(telomeres(10) + core + telomeres(10), 512);
+	auto rhs = make_helix(telomeres(10) + other + telomeres(10), 512);
+
+	auto expected = fine(lhs, rhs);
+	REQUIRE(expected.size() == 3);
+	REQUIRE(coarse(lhs, rhs, 1024) == expected);
+}
+
+TEST_CASE("Content defined blocks cover the helix and resync after an indel", "[coarse]")
+{
+	auto core = random_bases(200000, 134);
+	auto other = core.substr(0, 30000) + "GATTACA" + core.substr(30000);
+	auto lhs = blocks_of(make_helix(core));
+	auto rhs = blocks_of(make_helix(other));
+
+	std::size_t covered = 0;
+	for (const auto& block : lhs)
+	{
+		REQUIRE(block.first == covered);
+		REQUIRE(block.count <= 4 * dna::digest_block_bases);
+		covered += block.count;
+	}
+	REQUIRE(covered == core.size());
+	REQUIRE(lhs.size() > core.size() / (2 * dna::digest_block_bases));
+	REQUIRE(lhs.size() < 2 * core.size() / dna::digest_block_bases);
+
+	// Past the block holding the insertion, every block reappears 7 bases
+	// on, but the last: the rhs helix is padded out to a whole byte.
+	std::size_t checked = 0;
+	for (const auto& block : lhs)
+	{
+		if (block.first < 30000 + 4 * dna::digest_block_bases || block.first + block.count == core.size())
+			continue;
+		auto found = std::find_if(rhs.begin(), rhs.end(), [&](const dna::digest_block& right)
+				{ return right.first == block.first + 7 && right.count == block.count && right.digest == block.digest; });
+		REQUIRE(found != rhs.end());
+		++checked;
+	}
+	REQUIRE(checked > 10);
+}
+
+TEST_CASE("Computed digests answer with the block holding a position", "[coarse]")
+{
+	auto helix = make_helix(random_bases(50000, 135), 512);
+	auto blocks = blocks_of(helix);
+	dna::computed_digests<fake_stream> digests(helix);
+
+	auto middle = blocks[3].first + blocks[3].count / 2;
+	REQUIRE(digests.block_at(middle)->first == blocks[3].first);
+	REQUIRE(digests.block_at(blocks[5].first)->digest == blocks[5].digest);
+	REQUIRE(digests.block_at(0)->first == 0);
+	REQUIRE(!digests.block_at(50000));
+}
+
+TEST_CASE("Coarse compare skips blocks with matching digests", "[coarse]")
+{
+	auto bases = telomeres(10) + random_bases(32000, 132) + telomeres(10);
+	auto plain = make_helix(bases, 512);
+	counting_stream lhs(plain);
+	counting_stream rhs(plain);
+	dna::computed_digests<fake_stream> lhs_digests(plain);
+	dna::computed_digests<fake_stream> rhs_digests(plain);
+
+	std::size_t found = 0;
+	dna::compare_coarse(lhs, rhs, lhs_digests, rhs_digests, 0, dna::frame_helices(plain, plain),
+			[&](const dna::difference&) { ++found; });
+	REQUIRE(found == 0);
+	REQUIRE(lhs.bytes() == 0);
+	REQUIRE(rhs.bytes() == 0);
+}
+
+TEST_CASE("Coarse compare resyncs dirty runs after an indel", "[coarse]")
+{
+	auto core = random_bases(400000, 133);
+	auto other = core.substr(0, 20000) + "GATTACA" + core.substr(20000);
+
+	auto lhs_bases = telomeres(10) + core + telomeres(10);
+	auto rhs_bases = telomeres(10) + other + telomeres(10);
+	counting_stream lhs(make_helix(lhs_bases, 512));
+	counting_stream rhs(make_helix(rhs_bases, 512));
+	auto lhs_plain = make_helix(lhs_bases, 512);
+	auto rhs_plain = make_helix(rhs_bases, 512);
+	dna::computed_digests<fake_stream> lhs_digests(lhs_plain);
+	dna::computed_digests<fake_stream> rhs_digests(rhs_plain);
+
+	std::vector<dna::difference> found;
+	dna::compare_coarse(lhs, rhs, lhs_digests, rhs_digests, 0, dna::frame_helices(lhs_plain, rhs_plain),
+			[&](const dna::difference& d) { found.push_back(d); });
+	REQUIRE(found == fine(lhs_plain, rhs_plain));
+	REQUIRE(found.size() == 1);
+
+	// Only the blocks around the insertion and its resync windows are read
+	// base by base; a stale offset would drag the run to the end.
+	auto bytes = (lhs_bases.size() + rhs_bases.size()) / 4;
+	REQUIRE(lhs.bytes() + rhs.bytes() < bytes / 2);
+}
+
+TEST_CASE("Coarse compare reads only around a small indel near the start", "[coarse]")
+{
+	auto core = random_bases(1000000, 136);
+	auto other = core.substr(0, 1500) + core.substr(1505);
+	other[700000] = other[700000] == 'A' ? 'C' : 'A';
+
+	auto lhs_bases = telomeres(10) + core + telomeres(10);
+	auto rhs_bases = telomeres(12) + other + telomeres(10);
+	counting_stream lhs(make_helix(lhs_bases, 512));
+	counting_stream rhs(make_helix(rhs_bases, 512));
+	auto lhs_plain = make_helix(lhs_bases, 512);
+	auto rhs_plain = make_helix(rhs_bases, 512);
+	dna::computed_digests<fake_stream> lhs_digests(lhs_plain);
+	dna::computed_digests<fake_stream> rhs_digests(rhs_plain);
+
+	std::vector<dna::difference> found;
+	dna::compare_coarse(lhs, rhs, lhs_digests, rhs_digests, 0, dna::frame_helices(lhs_plain, rhs_plain),
+			[&](const dna::difference& d) { found.push_back(d); });
+	REQUIRE(found == fine(lhs_plain, rhs_plain));
+	REQUIRE(found.size() == 2);
+
+	// The deletion is 5 bases, not a whole block, yet past it the blocks
+	// line up again: only the runs around the two differences and their
+	// resync windows are read, a few blocks out of a million bases.
+	auto bases = lhs_bases.size() + rhs_bases.size();
+	auto read = 4 * (lhs.bytes() + rhs.bytes());
+	REQUIRE(read < bases / 10);
+}
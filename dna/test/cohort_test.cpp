@@ -0,0 +1,43 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <cohort.hpp>
+
+namespace
+{
+
+std::vector<std::string> genome(unsigned seed)
+{
+	std::vector<std::string> result;
+	for (unsigned i = 0; i < 23; ++i)
+		result.push_back(telomeres(10) + random_bases(6000, seed + i) + telomeres(10));
+	return result;
+}
+
+}
+
+TEST_CASE("One-vs-many matches pairwise comparisons", "[cohort]")
+{
+	auto base = genome(70);
+
+	auto snps = base;
+	snps[1][60 + 100] = snps[1][60 + 100] == 'A' ? 'C' : 'A';
+	snps[7][60 + 5999] = snps[7][60 + 5999] == 'A' ? 'C' : 'A';
+
+	auto indel = base;
+	indel[4] = telomeres(14) + base[4].substr(60, 3000) + "GATTACA" + base[4].substr(60 + 3000);
+	indel[9] = base[9].substr(0, 60 + 2000) + base[9].substr(60 + 2100);
+
+	auto query = make_person(base);
+	auto first = make_person(snps);
+	auto second = make_person(indel);
+
+	std::vector<std::reference_wrapper<const fake_person>> cohort{first, second};
+	auto shared = dna::compare_one_to_many(query, cohort, 4, 1000);
+
+	REQUIRE(shared.size() == 2);
+	REQUIRE(shared[0] == dna::compare_people(query, first));
+	REQUIRE(shared[1] == dna::compare_people(query, second));
+	REQUIRE(shared[1].size() == 2);
+	REQUIRE(shared[1][0].kind == dna::difference_kind::insertion);
+	REQUIRE(shared[1][1].kind == dna::difference_kind::deletion);
+}
@@ -0,0 +1,62 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <compare.hpp>
+
+TEST_CASE("XOR kernel marks every differing base", "[compare]")
+{
+	auto lhs = dna::pack(dna::A, dna::C, dna::G, dna::T);
+	auto rhs = dna::pack(dna::A, dna::G, dna::G, dna::A);
+
+	auto mask = dna::mismatch_mask(static_cast<dna::packed_word>(lhs) << 56, static_cast<dna::packed_word>(rhs) << 56);
+	REQUIRE(dna::mismatch_count(mask) == 2);
+	REQUIRE(dna::first_base(mask) == 1);
+	REQUIRE(dna::last_base(mask) == 3);
+}
+
+TEST_CASE("Packed windows can start on any base", "[compare]")
+{
+	auto bases = random_bases(200, 7);
+	auto helix = make_helix(bases, 8);
+
+	auto window = dna::load_packed(helix, 37, 100);
+	REQUIRE(window.size() == 100);
+	for (std::size_t i = 0; i < window.size(); ++i)
+		REQUIRE(dna::to_char(window[i]) == bases[37 + i]);
+	REQUIRE(dna::base_at(window.word(90), 9) == base_of(bases[136]));
+	REQUIRE(window.word(95) << 10 == 0);
+}
+
+TEST_CASE("Comparing helices reports runs of substitutions", "[compare]")
+{
+	auto lhs = random_bases(4000, 1);
+	auto rhs = lhs;
+	rhs[10] = lhs[10] == 'A' ? 'C' : 'A';
+	for (std::size_t i = 1020; i < 1030; ++i)
+		rhs[i] = lhs[i] == 'G' ? 'T' : 'G';
+
+	auto a = make_helix(lhs);
+	auto b = make_helix(rhs);
+	auto found = dna::collect_differences(a, b, 3, dna::full_range(a, b), 1024);
+
+	REQUIRE(found.size() == 2);
+	REQUIRE(found[0].chromosome == 3);
+	REQUIRE(found[0].start == 10);
+	REQUIRE(found[0].length == 1);
+	REQUIRE(dna::base_at(found[0].alternate, 0) == base_of(rhs[10]));
+	REQUIRE(found[1].start == 1020);
+	REQUIRE(found[1].length == 10);
+	REQUIRE(dna::base_at(found[1].alternate, 9) == base_of(rhs[1029]));
+}
+
+TEST_CASE("Offset ranges compare shifted bases", "[compare]")
+{
+	auto core = random_bases(1000, 2);
+	auto lhs = "GGG" + core;
+	auto rhs = "TTTTTTT" + core;
+	rhs[7 + 500] = core[500] == 'A' ? 'T' : 'A';
+
+	auto found = dna::collect_differences(make_helix(lhs), make_helix(rhs), 0, dna::aligned_range{3, 7, 1000}, 64);
+	REQUIRE(found.size() == 1);
+	REQUIRE(found[0].start == 503);
+	REQUIRE(found[0].other_start == 507);
+}
@@ -0,0 +1,126 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <consensus.hpp>
+
+namespace
+{
+
+dna::packed_word pack_word(const std::string& bases)
+{
+	dna::packed_word word = 0;
+	for (std::size_t i = 0; i < bases.size(); ++i)
+		word |= dna::base_word(base_of(bases[i]), i);
+	return word;
+}
+
+}
+
+TEST_CASE("Bit-sliced votes pick the majority base", "[consensus]")
+{
+	dna::base_vote vote(5);
+	vote.add(pack_word("ACGTACGT"), 8);
+	vote.add(pack_word("ACGTTTTT"), 8);
+	vote.add(pack_word("CCGGTTTT"), 8);
+	vote.add(pack_word("GATC"), 4);
+
+	auto winner = vote.winner();
+	std::string expected = "ACGTTTTT";
+	for (std::size_t i = 0; i < expected.size(); ++i)
+		REQUIRE(dna::base_at(winner, i) == base_of(expected[i]));
+	REQUIRE(dna::base_at(winner, 8) == dna::A);
+}
+
+TEST_CASE("Votes over a shard keep each word apart", "[consensus]")
+{
+	dna::base_vote vote(3, 2);
+	vote.add(pack_word("GGGG"), 4, 1);
+	vote.add(pack_word("GGTT"), 4, 1);
+	vote.add(pack_word("CCCC"), 4, 0);
+
+	REQUIRE(dna::base_at(vote.winner(0), 0) == dna::C);
+	REQUIRE(dna::base_at(vote.winner(1), 1) == dna::G);
+	REQUIRE(dna::base_at(vote.winner(1), 3) == dna::G);
+	REQUIRE(dna::base_at(vote.winner(1), 4) == dna::A);
+}
+
+TEST_CASE("Consensus recovers the shared genome", "[consensus]")
+{
+	std::vector<std::string> reference;
+	for (unsigned c = 0; c < 23; ++c)
+		reference.push_back("C" + random_bases(3000 + 32 * c, 180 + c) + telomeres(4));
+
+	std::vector<fake_person> people;
+	for (unsigned p = 0; p < 5; ++p)
+	{
+		std::vector<std::string> chromosomes;
+		for (unsigned c = 0; c < 23; ++c)
+		{
+			auto body = reference[c];
+			for (std::size_t i = 7 * p + 1; i < 2900; i += 97)
+				body[i] = body[i] == 'A' ? 'T' : 'A';
+			auto head = telomeres(3 + p);
+			chromosomes.push_back(head + body + std::string((4 - (head.size() + body.size()) % 4) % 4, 'A'));
+		}
+		people.push_back(make_person(chromosomes));
+	}
+
+	std::vector<std::reference_wrapper<const fake_person>> cohort(people.begin(), people.end());
+	std::vector<std::string> built(23);
+	std::size_t next = 0;
+	dna::build_consensus(cohort, [&](std::size_t chromosome, std::size_t first, const dna::packed_sequence& bases)
+	{
+		REQUIRE(first == built[chromosome].size());
+		next = chromosome;
+		for (std::size_t i = 0; i < bases.size(); ++i)
+			built[chromosome].push_back(dna::to_char(bases[i]));
+	}, 4, 1024);
+
+	REQUIRE(next == 22);
+	for (unsigned c = 0; c < 23; ++c)
+		REQUIRE(built[c].substr(0, reference[c].size()) == reference[c]);
+}
+
+TEST_CASE("Runs of bases vote at any base of the shard", "[consensus]")
+{
+	dna::base_vote vote(1, 3);
+	auto bases = random_bases(40, 182);
+	auto helix = make_helix(bases + "AAAA");
+	vote.add(dna::load_packed(helix, 0, 40), 20);
+
+	for (std::size_t i = 0; i < 40; ++i)
+		REQUIRE(dna::base_at(vote.winner((20 + i) / 32), (20 + i) % 32) == base_of(bases[i]));
+}
+
+TEST_CASE("Consensus aligns voters with indels to the reference", "[consensus]")
+{
+	auto reference = "C" + random_bases(6000, 183) + "C";
+	auto person = [](std::string bases)
+	{
+		bases += std::string((4 - bases.size() % 4) % 4, 'A');
+		return make_person(std::vector<std::string>(23, bases));
+	};
+
+	// Three of five voters carry an indel, each in a different place, so
+	// lining them up by origin alone would lose the majority after 2200.
+	std::vector<fake_person> people;
+	people.push_back(person(random_bases(7000, 184)));
+	people.push_back(person(telomeres(5) + reference + telomeres(4)));
+	people.push_back(person(telomeres(3) + reference.substr(0, 800) + "GATTACA" + reference.substr(800) + telomeres(4)));
+	people.push_back(person(telomeres(4) + reference.substr(0, 1500) + reference.substr(1509) + telomeres(4)));
+	people.push_back(person(telomeres(6) + reference.substr(0, 2200) + "TTAGC" + reference.substr(2200) + telomeres(4)));
+	people.push_back(person(telomeres(2) + reference + telomeres(4)));
+
+	std::vector<std::reference_wrapper<const fake_person>> cohort(people.begin(), people.end());
+	std::string built;
+	dna::build_consensus(cohort, [&](std::size_t chromosome, std::size_t, const dna::packed_sequence& bases)
+	{
+		if (chromosome != 0)
+			return;
+		for (std::size_t i = 0; i < bases.size(); ++i)
+			built.push_back(dna::to_char(bases[i]));
+	}, 4, 1024);
+
+	// The voter with no telomeres sits out; the first one with them is the
+	// reference.
+	REQUIRE(built.substr(0, reference.size()) == reference);
+}
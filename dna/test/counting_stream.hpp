@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include "fake_stream.hpp"
+
+// Counts the bytes read through it, shared between copies.
+class counting_stream
+{
+	fake_stream helix_;
+	std::shared_ptr<std::size_t> bytes_;
+public:
+	explicit counting_stream(fake_stream helix) :
+			helix_(std::move(helix)),
+			bytes_(std::make_shared<std::size_t>(0))
+	{ }
+
+	void seek(long offset)
+	{
+		helix_.seek(offset);
+	}
+
+	long size() const
+	{
+		return helix_.size();
+	}
+
+	dna::sequence_buffer<fake_stream::byte_view> read()
+	{
+		auto chunk = helix_.read();
+		*bytes_ += chunk.buffer().size();
+		return chunk;
+	}
+
+	std::size_t bytes() const
+	{
+		return *bytes_;
+	}
+};
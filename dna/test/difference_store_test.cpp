@@ -0,0 +1,101 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <difference_store.hpp>
+
+namespace
+{
+
+std::vector<dna::difference> random_differences(std::size_t count, unsigned seed)
+{
+	std::mt19937 random(seed);
+	std::vector<dna::difference> result;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		auto kind = static_cast<dna::difference_kind>(random() % 3);
+		std::size_t chromosome = random() % 4;
+		std::size_t start = random() % 1000000;
+		std::size_t length = 1 + random() % 40;
+		dna::packed_word alternate = 0;
+		if (kind != dna::difference_kind::deletion)
+			alternate = (static_cast<dna::packed_word>(random()) << 32 | random()) &
+					(~dna::packed_word{0} << (64 - 2 * std::min<std::size_t>(length, 32)));
+		result.push_back(dna::difference{chromosome, start, length, start + random() % 50, kind, alternate});
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+}
+
+TEST_CASE("Difference store round trips every column", "[store]")
+{
+	auto found = random_differences(10000, 160);
+	auto path = temp_path("store_roundtrip.dnadif");
+	dna::write_difference_store(found, path, 512);
+
+	dna::difference_store store(path);
+	REQUIRE(store.size() == 10000);
+	REQUIRE(store.blocks() == 20);
+
+	std::vector<dna::difference> loaded;
+	store.for_each([&](const dna::difference& d) { loaded.push_back(d); });
+	REQUIRE(loaded == found);
+	std::remove(path.c_str());
+}
+
+TEST_CASE("Difference store scans a region", "[store]")
+{
+	auto found = random_differences(10000, 161);
+	auto path = temp_path("store_scan.dnadif");
+	dna::write_difference_store(found, path, 256);
+	dna::difference_store store(path);
+
+	std::vector<dna::difference> expected;
+	for (const auto& d : found)
+		if (d.chromosome == 2 && d.start < 400000 && std::max(d.end(), d.start + 1) > 350000)
+			expected.push_back(d);
+
+	std::vector<dna::difference> scanned;
+	store.scan(2, 350000, 400000, [&](const dna::difference& d) { scanned.push_back(d); });
+	REQUIRE(scanned == expected);
+	std::remove(path.c_str());
+}
+
+TEST_CASE("Difference store scans find long records from earlier blocks", "[store]")
+{
+	using dna::difference_kind;
+	std::vector<dna::difference> found{dna::difference{1, 1000, 500000, 1000, difference_kind::deletion, 0}};
+	for (std::size_t start = 2000; start < 900000; start += 1000)
+		found.push_back(dna::difference{1, start, 1, start, difference_kind::substitution, 0});
+	std::sort(found.begin(), found.end());
+
+	auto path = temp_path("store_reach.dnadif");
+	dna::write_difference_store(found, path, 16);
+	dna::difference_store store(path);
+
+	// Reach is a running maximum, so every block up to the deletion's end
+	// reaches past 450000 and the scan can't skip any of them.
+	REQUIRE(store.block(store.blocks() - 1).reach >= store.block(0).reach);
+	std::vector<dna::difference> scanned;
+	store.scan(1, 450000, 452000, [&](const dna::difference& d) { scanned.push_back(d); });
+	REQUIRE(scanned.size() == 3);
+	REQUIRE(scanned[0].length == 500000);
+
+	scanned.clear();
+	store.scan(1, 700000, 701500, [&](const dna::difference& d) { scanned.push_back(d); });
+	REQUIRE(scanned.size() == 2);
+	REQUIRE(scanned[0].start == 700000);
+	std::remove(path.c_str());
+}
+
+TEST_CASE("Difference store writer rejects unordered input", "[store]")
+{
+	using dna::difference_kind;
+	std::stringstream stream;
+	dna::difference_store_writer writer(stream, 4);
+	writer(dna::difference{1, 100, 1, 100, difference_kind::substitution, 0});
+	REQUIRE_THROWS_AS(writer(dna::difference{0, 200, 1, 200, difference_kind::substitution, 0}), std::invalid_argument);
+}
@@ -0,0 +1,62 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include "sized_person.hpp"
+#include <engine.hpp>
+
+namespace
+{
+
+constexpr long x_bytes = 156000000 / 4;
+constexpr long y_bytes = 57000000 / 4;
+
+std::vector<std::string> genome(unsigned seed, std::size_t bases = 400)
+{
+	std::vector<std::string> result;
+	for (unsigned i = 0; i < 23; ++i)
+		result.push_back(random_bases(bases, seed + i));
+	return result;
+}
+
+}
+
+TEST_CASE("Sex chromosome is classified from its size alone", "[engine]")
+{
+	sized_person female(x_bytes);
+	sized_person male(y_bytes);
+
+	REQUIRE(dna::classify_sex_chromosome(female.chromosome(22)) == dna::sex_chromosome::x);
+	REQUIRE(dna::classify_sex_chromosome(male.chromosome(22)) == dna::sex_chromosome::y);
+	REQUIRE_FALSE(dna::same_sex_chromosome(female, male));
+	REQUIRE(dna::same_sex_chromosome(male, sized_person(y_bytes + 1000)));
+	REQUIRE(female.chromosome(22).reads() == 0);
+}
+
+TEST_CASE("Mismatched sex chromosomes are skipped without reading them", "[engine]")
+{
+	sized_person female(x_bytes);
+	sized_person male(y_bytes);
+
+	auto chromosomes = dna::comparable_chromosomes(female, male);
+	REQUIRE(chromosomes.size() == 22);
+	REQUIRE(chromosomes.back() == 21);
+
+	dna::compare_people(female, male, 4);
+	REQUIRE(female.chromosome(22).reads() == 0);
+	REQUIRE(male.chromosome(22).reads() == 0);
+	REQUIRE(female.chromosome(0).reads() > 0);
+}
+
+TEST_CASE("Comparing people reports differences per chromosome", "[engine]")
+{
+	auto lhs = genome(10);
+	auto rhs = lhs;
+	rhs[2][17] = lhs[2][17] == 'A' ? 'C' : 'A';
+	rhs[22][300] = lhs[22][300] == 'A' ? 'C' : 'A';
+
+	auto found = dna::compare_people(make_person(lhs), make_person(rhs), 4);
+	REQUIRE(found.size() == 2);
+	REQUIRE(found[0].chromosome == 2);
+	REQUIRE(found[0].start == 17);
+	REQUIRE(found[1].chromosome == 22);
+	REQUIRE(found[1].start == 300);
+}
@@ -4,6 +4,9 @@
 #include <string_view>
 #include <vector>
 #include <atomic>
+#include <cwchar>
+#include <ios>
+#include <stdexcept>
 #include <sequence_buffer.hpp>
 
 namespace detail
@@ -12,6 +15,12 @@ namespace detail
 class binary_traits
 {
 public:
+	using char_type = std::byte;
+	using int_type = int;
+	using pos_type = std::streampos;
+	using off_type = std::streamoff;
+	using state_type = std::mbstate_t;
+
 	static constexpr std::byte to_upper(std::byte c) noexcept {
 		return c;
 	}
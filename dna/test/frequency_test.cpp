@@ -0,0 +1,96 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <cstdio>
+#include <sstream>
+#include <frequency.hpp>
+
+namespace
+{
+
+dna::difference snp(std::size_t chromosome, std::size_t position, dna::base value)
+{
+	return dna::difference{chromosome, position, 1, position, dna::difference_kind::substitution, dna::base_word(value, 0)};
+}
+
+}
+
+TEST_CASE("Allele counts add up across people and shards", "[frequency]")
+{
+	std::vector<std::string> paths;
+	for (std::size_t person = 0; person < 40; ++person)
+	{
+		std::vector<dna::difference> found;
+		for (std::size_t position = 0; position < 2000; position += 10)
+			if ((position / 10) % (person % 4 + 1) == 0)
+				found.push_back(snp(position % 3, position, position % 20 ? dna::G : dna::T));
+		found.push_back(snp(7, 123456, person % 2 ? dna::A : dna::C));
+
+		paths.push_back(temp_path("frequency_" + std::to_string(person) + ".dnadif"));
+		dna::write_difference_store(found, paths.back(), 64);
+	}
+
+	std::vector<dna::difference_store> stores;
+	for (const auto& path : paths)
+		stores.emplace_back(path);
+	std::vector<std::reference_wrapper<const dna::difference_store>> people(stores.begin(), stores.end());
+
+	// A tiny capacity makes every shard grow several times.
+	for (std::size_t capacity : {std::size_t{64}, std::size_t{1} << 16})
+	{
+		auto table = dna::aggregate_frequencies(people, 4, capacity, 8);
+		REQUIRE(table.people == 40);
+		REQUIRE(table.alleles.size() == 202);
+		REQUIRE(std::is_sorted(table.alleles.begin(), table.alleles.end(),
+				[](const dna::allele_count& lhs, const dna::allele_count& rhs) { return lhs.key < rhs.key; }));
+
+		auto at = [&](std::size_t chromosome, std::size_t position)
+		{
+			return std::find_if(table.alleles.begin(), table.alleles.end(), [&](const dna::allele_count& each)
+			{
+				return each.key.chromosome == chromosome && each.key.position == position;
+			});
+		};
+		REQUIRE(at(0, 0)->carriers == 40);
+		REQUIRE(at(0, 60)->carriers == 30);
+		REQUIRE(at(1, 10)->carriers == 10);
+		REQUIRE(at(7, 123456)->carriers == 20);
+
+		std::stringstream stream;
+		dna::write_frequency_table(table, stream);
+		auto loaded = dna::read_frequency_table(stream);
+		REQUIRE(loaded.alleles.size() == table.alleles.size());
+		REQUIRE(loaded.alleles[5].key == table.alleles[5].key);
+		REQUIRE(loaded.frequency(5) == table.frequency(5));
+	}
+
+	stores.clear();
+	for (const auto& path : paths)
+		std::remove(path.c_str());
+}
+
+TEST_CASE("Allele counts split substitution runs per base", "[frequency]")
+{
+	auto alternate = dna::base_word(dna::C, 0) | dna::base_word(dna::G, 1) | dna::base_word(dna::T, 2);
+	dna::difference run{3, 100, 3, 100, dna::difference_kind::substitution, alternate};
+
+	auto run_path = temp_path("frequency_run.dnadif");
+	auto lone_path = temp_path("frequency_lone.dnadif");
+	dna::write_difference_store({run}, run_path);
+	dna::write_difference_store({snp(3, 101, dna::G)}, lone_path);
+
+	{
+		dna::difference_store with_run(run_path);
+		dna::difference_store with_lone(lone_path);
+		auto table = dna::aggregate_frequencies({with_run, with_lone}, 2);
+
+		REQUIRE(table.alleles.size() == 3);
+		REQUIRE(table.alleles[0].key.position == 100);
+		REQUIRE(table.alleles[1].key == dna::variant{3, 101, 1, dna::difference_kind::substitution, dna::base_word(dna::G, 0)});
+		REQUIRE(table.alleles[1].carriers == 2);
+		REQUIRE(table.frequency(1) == 1.0);
+		REQUIRE(table.alleles[2].carriers == 1);
+	}
+
+	std::remove(run_path.c_str());
+	std::remove(lone_path.c_str());
+}
@@ -0,0 +1,53 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <identity.hpp>
+
+namespace
+{
+
+std::vector<dna::aligned_range> runs(fake_stream& lhs, fake_stream& rhs, std::size_t min_length, std::size_t chunk)
+{
+	auto map = dna::map_alignment(lhs, rhs, dna::frame_helices(lhs, rhs));
+	std::vector<dna::aligned_range> result;
+	dna::find_identical_runs(lhs, rhs, 0, map, min_length,
+			[&](const dna::identical_run& run) { result.push_back(run.range); }, chunk);
+	return result;
+}
+
+}
+
+TEST_CASE("Identical runs stop at mismatches", "[identity]")
+{
+	auto core = "C" + random_bases(20000, 220);
+	auto other = core;
+	for (std::size_t position : {3000u, 3001u, 3100u, 12345u})
+		other[position] = other[position] == 'A' ? 'G' : 'A';
+
+	auto lhs = make_helix(telomeres(4) + core + telomeres(4), 512);
+	auto rhs = make_helix(telomeres(4) + other + telomeres(4), 512);
+	auto frame = dna::frame_helices(lhs, rhs);
+
+	for (std::size_t chunk : {std::size_t{64}, std::size_t{1000}, dna::default_chunk_bases})
+	{
+		auto found = runs(lhs, rhs, 1000, chunk);
+		REQUIRE(found.size() == 3);
+		REQUIRE(found[0] == dna::aligned_range{frame.lhs_begin, frame.rhs_begin, 3024 - frame.lhs_begin});
+		REQUIRE(found[1] == dna::aligned_range{3125, 3125, 12369 - 3125});
+		REQUIRE(found[2].lhs == 12370);
+		REQUIRE(found[2].lhs + found[2].length == frame.lhs_end);
+	}
+
+	REQUIRE(runs(lhs, rhs, 9000, 4096).size() == 1);
+}
+
+TEST_CASE("Indels break identical runs", "[identity]")
+{
+	auto core = "C" + random_bases(20000, 221);
+	auto other = core.substr(0, 10000) + "GATTACA" + core.substr(10000);
+
+	auto lhs = make_helix(telomeres(4) + core + telomeres(4), 512);
+	auto rhs = make_helix(telomeres(4) + other + telomeres(4), 512);
+	auto found = runs(lhs, rhs, 5000, 4096);
+	REQUIRE(found.size() == 2);
+	REQUIRE(found[1].rhs - found[1].lhs == 7);
+}
@@ -0,0 +1,81 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <cstdio>
+#include <random>
+#include <interval_index.hpp>
+
+namespace
+{
+
+std::vector<dna::difference> scattered(std::size_t count, unsigned seed)
+{
+	std::mt19937 random(seed);
+	std::vector<dna::difference> result;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		auto kind = static_cast<dna::difference_kind>(random() % 3);
+		std::size_t start = random() % 500000;
+		std::size_t length = 1 + (random() % 50 == 0 ? random() % 20000 : random() % 10);
+		result.push_back(dna::difference{random() % 3, start, length, start, kind, 0});
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+// Writes a store and its interval index to temp files, returns the store's.
+std::string stored(const std::vector<dna::difference>& found, const std::string& name)
+{
+	auto path = temp_path(name);
+	dna::write_difference_store(found, path, 128);
+	dna::write_interval_index(dna::difference_store(path), dna::interval_index_path_for(path));
+	return path;
+}
+
+void remove_stored(const std::string& path)
+{
+	std::remove(path.c_str());
+	std::remove(dna::interval_index_path_for(path).c_str());
+}
+
+}
+
+TEST_CASE("Interval index matches a linear scan", "[interval]")
+{
+	auto found = scattered(5000, 171);
+	auto path = stored(found, "interval_scan.dnadif");
+	dna::interval_index index(dna::interval_index_path_for(path));
+	dna::difference_store store(path);
+
+	for (std::size_t from : {0u, 1000u, 123456u, 499990u})
+	{
+		auto to = from + 3000;
+		std::vector<dna::difference> expected;
+		for (const auto& d : found)
+			if (d.chromosome == 1 && d.start < to && std::max(d.end(), d.start + 1) > from)
+				expected.push_back(d);
+
+		std::vector<dna::difference> located;
+		for (auto record : index.query(1, from, to))
+			located.push_back(store.record(record));
+		REQUIRE(located == expected);
+	}
+	remove_stored(path);
+}
+
+TEST_CASE("Interval indexes tell which pairs differ in a region", "[interval]")
+{
+	using dna::difference_kind;
+	std::vector<std::string> paths{
+			stored({{6, 55100000, 1, 55100000, difference_kind::substitution, 0}}, "pair_first.dnadif"),
+			stored({{6, 54000000, 2000000, 54000000, difference_kind::deletion, 0}}, "pair_second.dnadif"),
+			stored({{6, 56000000, 1, 56000000, difference_kind::substitution, 0},
+					{7, 55100000, 1, 55100000, difference_kind::substitution, 0}}, "pair_third.dnadif")};
+	dna::interval_index first(dna::interval_index_path_for(paths[0]));
+	dna::interval_index second(dna::interval_index_path_for(paths[1]));
+	dna::interval_index third(dna::interval_index_path_for(paths[2]));
+
+	auto pairs = dna::differing_pairs({first, second, third}, 6, 55000000, 55300000);
+	REQUIRE(pairs == std::vector<std::size_t>{0, 1});
+	for (const auto& path : paths)
+		remove_stored(path);
+}
@@ -0,0 +1,73 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <lazy_compare.hpp>
+
+TEST_CASE("Lazy differences match the eager comparison", "[lazy]")
+{
+	auto lhs = random_bases(3000, 3);
+	auto rhs = lhs;
+	for (std::size_t i : {5, 6, 7, 511, 512, 513, 2999})
+		rhs[i] = lhs[i] == 'C' ? 'G' : 'C';
+
+	auto a = make_helix(lhs);
+	auto b = make_helix(rhs);
+	auto expected = dna::collect_differences(a, b, 0, dna::full_range(a, b), 512);
+
+	std::vector<dna::difference> found;
+	for (const auto& d : dna::lazy_differences(a, b, 0, dna::full_range(a, b), 512))
+		found.push_back(d);
+
+	REQUIRE(found == expected);
+	REQUIRE(found.size() == 3);
+	REQUIRE(found[1].start == 511);
+	REQUIRE(found[1].length == 3);
+}
+
+TEST_CASE("Lazy comparisons can be interleaved and abandoned", "[lazy]")
+{
+	auto lhs = random_bases(2000, 4);
+	auto rhs = lhs;
+	rhs[100] = lhs[100] == 'A' ? 'T' : 'A';
+	rhs[1900] = lhs[1900] == 'A' ? 'T' : 'A';
+
+	auto a = make_helix(lhs);
+	auto b = make_helix(rhs);
+	auto first = dna::lazy_differences(a, b, 0, dna::full_range(a, b), 256);
+	auto second = dna::lazy_differences(b, a, 1, dna::full_range(a, b), 256);
+
+	auto it1 = first.begin();
+	auto it2 = second.begin();
+	REQUIRE(it1->start == 100);
+	REQUIRE(it2->chromosome == 1);
+	++it1;
+	REQUIRE(it1->start == 1900);
+	++it1;
+	REQUIRE(it1 == first.end());
+	REQUIRE(it2->start == 100);
+}
+
+TEST_CASE("Lazy differences over an alignment map match the engine", "[lazy]")
+{
+	auto core = "C" + random_bases(6000, 5) + "C";
+	auto other = core.substr(0, 2000) + "GATTACA" + core.substr(2000);
+	for (std::size_t i : {500, 4100, 4101, 5800})
+		other[i] = other[i] == 'A' ? 'T' : 'A';
+
+	auto lhs_bases = telomeres(4) + core + telomeres(4);
+	auto rhs_bases = telomeres(6) + other + telomeres(4);
+	auto lhs = make_helix(lhs_bases + std::string((4 - lhs_bases.size() % 4) % 4, 'A'));
+	auto rhs = make_helix(rhs_bases + std::string((4 - rhs_bases.size() % 4) % 4, 'A'));
+	auto map = dna::map_alignment(lhs, rhs, dna::frame_helices(lhs, rhs));
+
+	std::vector<dna::difference> expected;
+	dna::compare_mapped(lhs, rhs, 3, map, [&](const dna::difference& d) { expected.push_back(d); }, 1024);
+
+	std::vector<dna::difference> found;
+	for (const auto& d : dna::lazy_differences(lhs, rhs, 3, map, 1024))
+		found.push_back(d);
+
+	REQUIRE(map.size() == 2);
+	REQUIRE(found == expected);
+	REQUIRE(std::count_if(found.begin(), found.end(),
+			[](const dna::difference& d) { return d.kind == dna::difference_kind::insertion; }) == 1);
+}
@@ -1,2 +1,4 @@
 #define CATCH_CONFIG_MAIN
+// glibc 2.34+ no longer has a constant MINSIGSTKSZ, which Catch's signal handler needs.
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
 #include "catch.hpp"
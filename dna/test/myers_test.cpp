@@ -0,0 +1,127 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <alignment_map.hpp>
+
+namespace
+{
+
+dna::packed_sequence packed(const std::string& bases)
+{
+	dna::packed_sequence result;
+	for (auto c : bases)
+		result.push_back(base_of(c));
+	return result;
+}
+
+}
+
+TEST_CASE("Pattern masks come straight from packed words", "[myers]")
+{
+	auto masks = dna::pattern_masks(packed("ACGTTA" + std::string(30, 'C') + "G"), 0, 37);
+	REQUIRE(masks[0] == ((1ULL << 0) | (1ULL << 5)));
+	REQUIRE(masks[3] == ((1ULL << 3) | (1ULL << 4)));
+	REQUIRE(masks[2] == ((1ULL << 2) | (1ULL << 36)));
+}
+
+TEST_CASE("Bit-vector alignment finds edit distance and indels", "[myers]")
+{
+	auto lhs = random_bases(60, 40);
+	auto rhs = lhs.substr(0, 20) + lhs.substr(23, 25) + "GT" + lhs.substr(48);
+	rhs[5] = lhs[5] == 'A' ? 'C' : 'A';
+
+	auto aligned = dna::banded_align(packed(lhs), 0, lhs.size(), packed(rhs), 0, rhs.size(), 8);
+	REQUIRE(aligned);
+	REQUIRE(aligned->distance <= 6);
+
+	std::size_t deleted = 0, inserted = 0;
+	for (const auto& edit : aligned->edits)
+	{
+		if (edit.kind == dna::difference_kind::deletion)
+			deleted += edit.length;
+		if (edit.kind == dna::difference_kind::insertion)
+			inserted += edit.length;
+	}
+	REQUIRE(deleted == inserted + 1);
+	REQUIRE(aligned->distance == 6);
+
+	REQUIRE_FALSE(dna::banded_align(packed(lhs), 0, lhs.size(), packed(random_bases(60, 41)), 0, 60, 8));
+}
+
+TEST_CASE("Dense mismatch windows are reported as indels", "[myers]")
+{
+	auto core = random_bases(5000, 42);
+	auto shifted = core.substr(0, 2000) + core.substr(2001, 30) + "A" + core.substr(2031);
+
+	auto lhs = make_helix(telomeres(10) + core + telomeres(10), 64);
+	auto rhs = make_helix(telomeres(10) + shifted + telomeres(10), 64);
+	auto frame = dna::frame_helices(lhs, rhs);
+	auto map = dna::map_alignment(lhs, rhs, frame);
+
+	std::vector<dna::difference> found;
+	dna::compare_mapped(lhs, rhs, 0, map, [&](const dna::difference& d) { found.push_back(d); });
+
+	// core[2000] sits in an "AA" run, so the deletion is placed on its
+	// second base; the inserted A lands where the frames resync.
+	REQUIRE(map.size() == 1);
+	REQUIRE(found.size() == 2);
+	REQUIRE(found[0].kind == dna::difference_kind::deletion);
+	REQUIRE(found[0].start == 60 + 2001);
+	REQUIRE(found[0].length == 1);
+	REQUIRE(found[0].other_start == 60 + 2001);
+	REQUIRE(found[1].kind == dna::difference_kind::insertion);
+	REQUIRE(found[1].start == 60 + 2031);
+	REQUIRE(found[1].length == 1);
+	REQUIRE(found[1].other_start == 60 + 2030);
+	REQUIRE(found[1].alternate == 0);
+}
+
+namespace
+{
+
+std::size_t naive_distance(const std::string& lhs, const std::string& rhs)
+{
+	std::vector<std::size_t> row(rhs.size() + 1);
+	for (std::size_t j = 0; j <= rhs.size(); ++j)
+		row[j] = j;
+	for (std::size_t i = 1; i <= lhs.size(); ++i)
+	{
+		auto diagonal = row[0];
+		row[0] = i;
+		for (std::size_t j = 1; j <= rhs.size(); ++j)
+		{
+			auto up = row[j];
+			row[j] = std::min({up + 1, row[j - 1] + 1, diagonal + (lhs[i - 1] == rhs[j - 1] ? 0 : 1)});
+			diagonal = up;
+		}
+	}
+	return row.back();
+}
+
+}
+
+TEST_CASE("Band keeps windows longer than one block exact", "[myers]")
+{
+	auto lhs = random_bases(300, 43);
+	auto rhs = lhs.substr(0, 70) + lhs.substr(73, 100) + "CA" + lhs.substr(173);
+	rhs[250] = rhs[250] == 'G' ? 'T' : 'G';
+
+	auto aligned = dna::banded_align(packed(lhs), 0, lhs.size(), packed(rhs), 0, rhs.size(), 12);
+	REQUIRE(aligned);
+	REQUIRE(aligned->distance == naive_distance(lhs, rhs));
+
+	// Replaying the edits on lhs must give back rhs.
+	std::string replayed;
+	std::size_t at = 0;
+	for (const auto& edit : aligned->edits)
+	{
+		replayed += lhs.substr(at, edit.lhs - at);
+		if (edit.kind != dna::difference_kind::deletion)
+			replayed += rhs.substr(edit.rhs, edit.length);
+		at = edit.lhs + (edit.kind == dna::difference_kind::insertion ? 0 : edit.length);
+	}
+	replayed += lhs.substr(at);
+	REQUIRE(replayed == rhs);
+
+	REQUIRE_FALSE(dna::banded_align(packed(lhs), 0, lhs.size(), packed(rhs), 0, rhs.size(), 3));
+}
+
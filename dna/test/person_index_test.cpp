@@ -0,0 +1,79 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <region.hpp>
+
+namespace
+{
+
+std::vector<std::string> genome(std::size_t head_repeats, std::size_t tail_repeats, unsigned seed)
+{
+	std::vector<std::string> result;
+	for (unsigned i = 0; i < 23; ++i)
+	{
+		auto head = "GG" + telomeres(head_repeats + i);
+		auto body = random_bases(300 + (4 - (head.size() + 300) % 4) % 4, seed + i);
+		result.push_back(head + body + telomeres(tail_repeats * 2));
+	}
+	return result;
+}
+
+}
+
+TEST_CASE("Person index round trips telomere bounds", "[index]")
+{
+	auto person = make_person(genome(5, 7, 60));
+	auto index = dna::build_person_index(person, 4);
+
+	REQUIRE(index.chromosomes.size() == 23);
+	REQUIRE(index.chromosomes[4].head_repeats == 9);
+	REQUIRE(index.chromosomes[4].tail_repeats == 14);
+
+	std::stringstream stream;
+	dna::write_person_index(index, stream);
+	auto loaded = dna::read_person_index(stream);
+
+	REQUIRE(loaded.chromosomes.size() == 23);
+	REQUIRE(loaded.chromosomes[22].head_end == index.chromosomes[22].head_end);
+	REQUIRE(loaded.chromosomes[22].tail_begin == index.chromosomes[22].tail_begin);
+	REQUIRE(loaded.chromosomes[22].size == index.chromosomes[22].size);
+}
+
+TEST_CASE("Region lookups use the stored index", "[index]")
+{
+	auto query = make_person(genome(5, 3, 61));
+	auto target = make_person(genome(12, 3, 61));
+
+	auto query_path = dna::index_path_for(temp_path("query_genome"));
+	auto target_path = dna::index_path_for(temp_path("target_genome"));
+	dna::write_person_index(dna::build_person_index(query), query_path);
+	dna::write_person_index(dna::build_person_index(target), target_path);
+
+	REQUIRE(dna::read_index_entry(target_path, 3).head_repeats == 15);
+	REQUIRE_THROWS_AS(dna::read_index_entry(target_path, 23), std::out_of_range);
+
+	std::vector<dna::indexed_person<fake_person>> cohort{{target, target_path}};
+	auto results = dna::compare_region(dna::indexed_person<fake_person>{query, query_path}, dna::region{3, 20, 200}, cohort);
+	REQUIRE(results.size() == 1);
+	REQUIRE(results[0].located);
+	REQUIRE(results[0].differences.empty());
+
+	std::remove(query_path.c_str());
+	std::remove(target_path.c_str());
+}
+
+TEST_CASE("Single record lookups check the index header", "[index]")
+{
+	auto path = dna::index_path_for(temp_path("not_an_index"));
+	{
+		std::ofstream os(path, std::ios::binary);
+		os << std::string(64, 'x');
+	}
+
+	REQUIRE_THROWS_AS(dna::read_index_entry(path, 0), std::runtime_error);
+	REQUIRE_THROWS_AS(dna::read_index_sketch(path, 0), std::runtime_error);
+
+	std::remove(path.c_str());
+}
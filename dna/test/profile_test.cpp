@@ -0,0 +1,110 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <profile.hpp>
+
+namespace
+{
+
+std::vector<std::size_t> profile(fake_stream& lhs, fake_stream& rhs, std::size_t window, std::size_t step)
+{
+	auto frame = dna::frame_helices(lhs, rhs);
+	auto map = dna::map_alignment(lhs, rhs, frame);
+	std::vector<std::size_t> counts;
+	dna::divergence_profile(lhs, rhs, frame, map, [&](std::size_t start, std::size_t mismatches)
+	{
+		REQUIRE(start == counts.size() * step);
+		counts.push_back(mismatches);
+	}, window, step);
+	return counts;
+}
+
+}
+
+TEST_CASE("Window counts match a direct count", "[profile]")
+{
+	auto core = "C" + random_bases(9000, 210);
+	auto other = core;
+	std::vector<std::size_t> changed;
+	for (std::size_t i = 13; i < core.size(); i += 37 + i % 11)
+	{
+		other[i] = other[i] == 'G' ? 'T' : 'G';
+		changed.push_back(i + 24);
+	}
+
+	auto lhs = make_helix(telomeres(4) + core + telomeres(4), 256);
+	auto rhs = make_helix(telomeres(4) + other + telomeres(4), 256);
+	auto counts = profile(lhs, rhs, 1000, 100);
+
+	auto size = dna::helix_size(lhs);
+	REQUIRE(counts.size() == (size - 1000) / 100 + 1);
+	for (std::size_t w = 0; w < counts.size(); ++w)
+	{
+		auto start = w * 100;
+		auto expected = std::count_if(changed.begin(), changed.end(),
+				[&](std::size_t position) { return position >= start && position < start + 1000; });
+		REQUIRE(counts[w] == static_cast<std::size_t>(expected));
+	}
+}
+
+TEST_CASE("Deleted bases count toward their windows", "[profile]")
+{
+	auto core = "C" + random_bases(6000, 211);
+	auto other = core.substr(0, 3000) + core.substr(3040);
+
+	auto lhs = make_helix(telomeres(4) + core + telomeres(4), 256);
+	auto rhs = make_helix(telomeres(4) + other + telomeres(4), 256);
+	auto counts = profile(lhs, rhs, 500, 500);
+
+	std::size_t total = 0;
+	for (auto count : counts)
+		total += count;
+	REQUIRE(total == 40);
+	REQUIRE(counts[6] == 40);
+}
+
+TEST_CASE("Divergence track round trips through a file", "[profile]")
+{
+	std::vector<std::string> lhs_bases;
+	std::vector<std::string> rhs_bases;
+	for (unsigned c = 0; c < 23; ++c)
+	{
+		auto core = "C" + random_bases(2000, 212 + c);
+		auto other = core;
+		other[500] = other[500] == 'A' ? 'C' : 'A';
+		lhs_bases.push_back(telomeres(4) + core + telomeres(4));
+		rhs_bases.push_back(telomeres(4) + other + telomeres(4));
+	}
+
+	auto path = temp_path("profile.dnatrk");
+	dna::write_divergence_track(make_person(lhs_bases), make_person(rhs_bases), path, 200, 100, 4);
+
+	{
+		dna::divergence_track track(path);
+		REQUIRE(track.window_bases() == 200);
+		REQUIRE(track.chromosomes() == 23);
+		REQUIRE(track.windows(3) == 19);
+		REQUIRE(track.at(3, 3) == 0);
+		REQUIRE(track.at(3, 4) == 1);
+		REQUIRE(track.at(3, 5) == 1);
+		REQUIRE(track.at(3, 6) == 0);
+		REQUIRE_THROWS_AS(track.at(3, 19), std::out_of_range);
+		REQUIRE_THROWS_AS(track.windows(23), std::out_of_range);
+	}
+
+	// A file cut short leaves the directory pointing past its end.
+	std::string bytes;
+	{
+		std::ifstream is(path, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+	}
+	{
+		std::ofstream os(path, std::ios::binary | std::ios::trunc);
+		os.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 2));
+	}
+	REQUIRE_THROWS_AS(dna::divergence_track(path), std::runtime_error);
+
+	std::remove(path.c_str());
+}
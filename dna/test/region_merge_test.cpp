@@ -0,0 +1,60 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <region_merge.hpp>
+
+TEST_CASE("Nearby differences merge into one region", "[merge]")
+{
+	using dna::difference_kind;
+	dna::region_arena arena;
+	dna::region_merger merger(arena, 10);
+
+	merger(dna::difference{0, 100, 1, 100, difference_kind::substitution, 0});
+	merger(dna::difference{0, 105, 2, 105, difference_kind::substitution, 0});
+	merger(dna::difference{0, 115, 3, 115, difference_kind::deletion, 0});
+	merger(dna::difference{0, 200, 4, 197, difference_kind::insertion, 0});
+	merger(dna::difference{1, 203, 1, 203, difference_kind::substitution, 0});
+	merger(dna::difference{1, 206, 8, 206, difference_kind::inversion, 0});
+	merger.flush();
+
+	REQUIRE(arena.size() == 3);
+	REQUIRE(arena[0] == dna::difference_region{100, 118, 6, 0, dna::region_has_deletion});
+	REQUIRE(arena[1] == dna::difference_region{200, 200, 4, 0, dna::region_has_insertion});
+	REQUIRE(arena[2] == dna::difference_region{203, 214, 9, 1, dna::region_has_inversion});
+	REQUIRE(arena[2].has_inversion());
+	REQUIRE_FALSE(arena[2].has_insertion());
+	REQUIRE_FALSE(arena[0].has_inversion());
+}
+
+TEST_CASE("Arena pages keep every region", "[merge]")
+{
+	dna::region_arena arena;
+	for (std::uint32_t i = 0; i < 10000; ++i)
+		arena.push_back(dna::difference_region{i, i + 1, 1, 0, 0});
+
+	REQUIRE(arena.size() == 10000);
+	REQUIRE(arena[9999].start == 9999);
+	REQUIRE(arena[4096].end == 4097);
+}
+
+TEST_CASE("People compare straight into regions", "[merge]")
+{
+	std::vector<std::string> lhs_bases;
+	std::vector<std::string> rhs_bases;
+	for (unsigned i = 0; i < 23; ++i)
+	{
+		auto core = random_bases(2000, 150 + i);
+		lhs_bases.push_back(telomeres(5) + core + telomeres(5));
+		if (i == 3)
+		{
+			core[500] = core[500] == 'A' ? 'G' : 'A';
+			core[520] = core[520] == 'A' ? 'G' : 'A';
+			core[1500] = core[1500] == 'A' ? 'G' : 'A';
+		}
+		rhs_bases.push_back(telomeres(5) + core + telomeres(5));
+	}
+
+	auto regions = dna::compare_regions(make_person(lhs_bases), make_person(rhs_bases), 50, 4);
+	REQUIRE(regions.size() == 2);
+	REQUIRE(regions[0] == dna::difference_region{530, 551, 2, 3, 0});
+	REQUIRE(regions[1].mismatches == 1);
+}
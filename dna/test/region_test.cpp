@@ -0,0 +1,74 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <region.hpp>
+
+namespace
+{
+
+std::vector<std::string> genome(std::size_t head_repeats, const std::string& chromosome_3)
+{
+	std::vector<std::string> result;
+	for (unsigned i = 0; i < 23; ++i)
+		result.push_back(telomeres(head_repeats) + (i == 3 ? chromosome_3 : random_bases(200, 50 + i)) + telomeres(4));
+	return result;
+}
+
+}
+
+TEST_CASE("A region is compared against a cohort", "[region]")
+{
+	auto core = random_bases(3000, 51);
+	auto variant = core;
+	variant[1200] = core[1200] == 'T' ? 'G' : 'T';
+
+	auto query = make_person(genome(10, core));
+	auto same = make_person(genome(25, core));
+	auto different = make_person(genome(4, variant));
+	auto lost = make_person(genome(0, core.substr(100)));
+
+	std::vector<std::reference_wrapper<const fake_person>> cohort{same, different, lost};
+	auto results = dna::compare_region(query, dna::region{3, 1000, 500}, cohort, 3);
+
+	REQUIRE(results.size() == 3);
+	REQUIRE(results[0].located);
+	REQUIRE(results[0].differences.empty());
+	REQUIRE(results[1].located);
+	REQUIRE(results[1].differences.size() == 1);
+	REQUIRE(results[1].differences[0].start == 60 + 1200);
+	REQUIRE(results[1].differences[0].other_start == 24 + 1200);
+	REQUIRE_FALSE(results[2].located);
+}
+
+TEST_CASE("A region is aligned across indels in each target", "[region]")
+{
+	auto core = "C" + random_bases(4000, 53) + "C";
+	auto shifted = core.substr(0, 300) + "ACGTTGA" + core.substr(300);
+	shifted[1207] = shifted[1207] == 'T' ? 'G' : 'T';
+	auto split = core.substr(0, 1300) + core.substr(1305);
+
+	auto query = make_person(genome(10, core));
+	auto inserted = make_person(genome(10, shifted));
+	auto deleted = make_person(genome(7, split));
+
+	std::vector<std::reference_wrapper<const fake_person>> cohort{inserted, deleted};
+	auto results = dna::compare_region(query, dna::region{3, 1000, 500}, cohort, 2);
+
+	REQUIRE(results[0].located);
+	REQUIRE(results[0].differences.size() == 1);
+	REQUIRE(results[0].differences[0].start == 60 + 1200);
+	REQUIRE(results[0].differences[0].other_start == 60 + 1207);
+
+	REQUIRE(results[1].located);
+	REQUIRE(results[1].differences.size() == 1);
+	REQUIRE(results[1].differences[0].kind == dna::difference_kind::deletion);
+	REQUIRE(results[1].differences[0].length == 5);
+	REQUIRE(results[1].differences[0].other_start == 42 + results[1].differences[0].start - 60);
+}
+
+TEST_CASE("A region can't be taken from a query without telomeres", "[region]")
+{
+	auto query = make_person(genome(0, random_bases(1000, 52)));
+	std::vector<std::reference_wrapper<const fake_person>> cohort{query};
+
+	REQUIRE_THROWS_AS(dna::compare_region(query, dna::region{3, 10, 10}, cohort), std::runtime_error);
+}
@@ -0,0 +1,52 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <sampling.hpp>
+
+TEST_CASE("Sampled divergence brackets the true rate", "[sampling]")
+{
+	auto core = random_bases(200000, 120);
+	auto other = core;
+	std::size_t changed = 0;
+	for (std::size_t i = 50; i < other.size(); i += 100, ++changed)
+		other[i] = other[i] == 'C' ? 'G' : 'C';
+	other = other.substr(0, 90000) + "ACG" + other.substr(90000);
+
+	auto lhs = make_helix(telomeres(10) + core + telomeres(10), 1024);
+	auto rhs = make_helix(telomeres(10) + other + telomeres(10), 1024);
+	auto frame = dna::frame_helices(lhs, rhs);
+
+	auto estimate = dna::estimate_divergence(lhs, rhs, frame, 400, 256, 7);
+	auto truth = static_cast<double>(changed) / core.size();
+
+	REQUIRE(estimate.windows == 400);
+	REQUIRE(estimate.lower <= truth);
+	REQUIRE(estimate.upper >= truth);
+	REQUIRE(estimate.upper - estimate.lower < truth);
+}
+
+TEST_CASE("Identical helices give a zero rate with a bounded interval", "[sampling]")
+{
+	auto bases = telomeres(10) + random_bases(40000, 121) + telomeres(10);
+	auto lhs = make_helix(bases, 1024);
+	auto rhs = make_helix(bases, 1024);
+
+	auto estimate = dna::estimate_divergence(lhs, rhs, dna::frame_helices(lhs, rhs), 200, 256, 8);
+	REQUIRE(estimate.mismatches == 0);
+	REQUIRE(estimate.rate == 0.0);
+	REQUIRE(estimate.upper > 0.0);
+	REQUIRE(estimate.upper < 0.001);
+}
+
+TEST_CASE("Windows past the end of rhs are not counted as divergent", "[sampling]")
+{
+	auto core = random_bases(40000, 122);
+	auto lhs = make_helix(telomeres(10) + core + telomeres(10), 1024);
+	auto rhs = make_helix(telomeres(10) + core.substr(0, 30000) + telomeres(10), 1024);
+
+	auto estimate = dna::estimate_divergence(lhs, rhs, dna::frame_helices(lhs, rhs), 200, 256, 9);
+	REQUIRE(estimate.windows < 200);
+	REQUIRE(estimate.windows > 100);
+	REQUIRE(estimate.sampled_bases == estimate.windows * 256);
+	REQUIRE(estimate.mismatches == 0);
+	REQUIRE(estimate.upper < 0.001);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <base.hpp>
+#include "fake_person.hpp"
+
+inline dna::base base_of(char c)
+{
+	switch (c)
+	{
+		case 'C':
+			return dna::C;
+		case 'G':
+			return dna::G;
+		case 'T':
+			return dna::T;
+		default:
+			return dna::A;
+	}
+}
+
+// Packs a base string, padding the last byte with adenine.
+inline std::vector<std::byte> pack_bases(std::string_view bases)
+{
+	std::vector<std::byte> data((bases.size() + 3) / 4);
+	for (std::size_t i = 0; i < bases.size(); ++i)
+		data[i / 4] |= static_cast<std::byte>(base_of(bases[i])) << (6 - 2 * (i % 4));
+	return data;
+}
+
+inline std::string random_bases(std::size_t count, unsigned seed)
+{
+	static constexpr char letters[] = "ACGT";
+
+	std::mt19937 engine(seed);
+	std::uniform_int_distribution<int> pick(0, 3);
+
+	std::string result(count, 'A');
+	for (auto& c : result)
+		c = letters[pick(engine)];
+	return result;
+}
+
+// A scratch file in the temp directory, unique to this test run. Callers
+// remove it when they are done.
+inline std::string temp_path(const std::string& name)
+{
+	static const auto run = std::to_string(std::random_device{}());
+	return (std::filesystem::temp_directory_path() / ("dna_test_" + run + "_" + name)).string();
+}
+
+inline std::string telomeres(std::size_t repeats)
+{
+	std::string result;
+	for (std::size_t i = 0; i < repeats; ++i)
+		result += "TTAGGG";
+	return result;
+}
+
+inline fake_stream make_helix(std::string_view bases, std::size_t chunk_size = 16)
+{
+	return fake_stream(pack_bases(bases), chunk_size);
+}
+
+inline fake_person make_person(const std::vector<std::string>& chromosomes, std::size_t chunk_size = 16)
+{
+	std::vector<std::vector<std::byte>> data;
+	for (const auto& bases : chromosomes)
+		data.push_back(pack_bases(bases));
+	return fake_person(data, chunk_size);
+}
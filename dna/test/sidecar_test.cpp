@@ -0,0 +1,125 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <cstdio>
+#include <sidecar.hpp>
+#include "counting_stream.hpp"
+
+TEST_CASE("Block sidecar round trips digests and composition", "[sidecar]")
+{
+	auto bases = random_bases(40000, 140);
+	auto helix = make_helix(bases, 256);
+	auto path = temp_path("sidecar_roundtrip.dnablk");
+	dna::write_block_sidecar(helix, path, 4096);
+
+	dna::block_sidecar sidecar(path);
+	REQUIRE(sidecar.bases() == 40000);
+	REQUIRE(sidecar.blocks() > 1);
+
+	// Records hold the scanner's blocks, which tile the helix.
+	dna::block_scanner<fake_stream> scanner(helix, 4096);
+	std::size_t block = 0;
+	while (auto scanned = scanner.next())
+	{
+		REQUIRE(block < sidecar.blocks());
+		REQUIRE(sidecar.first(block) == scanned->first);
+		REQUIRE(sidecar.count(block) == scanned->bases.size());
+		REQUIRE(sidecar.digest(block) == dna::block_digest(scanned->bases));
+		++block;
+	}
+	REQUIRE(block == sidecar.blocks());
+
+	auto last = sidecar.blocks() - 1;
+	auto from = bases.begin() + static_cast<long>(sidecar.first(last));
+	auto counts = sidecar.composition(last);
+	REQUIRE(counts[0] == std::count(from, bases.end(), 'A'));
+	REQUIRE(counts[1] == std::count(from, bases.end(), 'C'));
+	REQUIRE(counts[2] == std::count(from, bases.end(), 'G'));
+	REQUIRE(counts[3] == std::count(from, bases.end(), 'T'));
+
+	REQUIRE(dna::verify_block_sidecar(helix, sidecar).ok());
+	std::remove(path.c_str());
+}
+
+TEST_CASE("Sidecar verification reports damaged blocks", "[sidecar]")
+{
+	auto bases = random_bases(40000, 141);
+	auto helix = make_helix(bases, 256);
+	auto path = temp_path("sidecar_verify.dnablk");
+	dna::write_block_sidecar(helix, path, 4096);
+	dna::block_sidecar sidecar(path);
+
+	bases[20000] = bases[20000] == 'G' ? 'T' : 'G';
+	auto damaged = make_helix(bases, 256);
+	auto check = dna::verify_block_sidecar(damaged, sidecar);
+	REQUIRE_FALSE(check.ok());
+	REQUIRE(check.bad_blocks.size() == 1);
+	auto bad = check.bad_blocks[0];
+	REQUIRE(sidecar.first(bad) <= 20000);
+	REQUIRE(sidecar.first(bad) + sidecar.count(bad) > 20000);
+
+	auto shorter = make_helix(bases.substr(0, 30000), 256);
+	REQUIRE_FALSE(dna::verify_block_sidecar(shorter, sidecar).size_matches);
+	std::remove(path.c_str());
+}
+
+TEST_CASE("Sidecar answers with the block holding a position", "[sidecar]")
+{
+	auto helix = make_helix(random_bases(40000, 143), 256);
+	auto path = temp_path("sidecar_lookup.dnablk");
+	dna::write_block_sidecar(helix, path, 4096);
+	dna::block_sidecar sidecar(path);
+	dna::computed_digests<fake_stream> computed(helix, 4096);
+
+	for (std::size_t position : {0, 1, 4095, 4096, 17000, 39999})
+	{
+		auto stored = sidecar.block_at(position);
+		auto expected = computed.block_at(position);
+		REQUIRE(stored);
+		REQUIRE(stored->first == expected->first);
+		REQUIRE(stored->count == expected->count);
+		REQUIRE(stored->digest == expected->digest);
+	}
+	REQUIRE_FALSE(sidecar.block_at(40000));
+	std::remove(path.c_str());
+}
+
+TEST_CASE("Coarse compare reads stored digests", "[sidecar]")
+{
+	// Different head lengths and a small deletion near the start shift every
+	// later base on the rhs; the content-defined blocks still line up, so
+	// the stored digests skip everything but the runs around the deletion
+	// and the mismatch. The C ends keep the telomere scans out of the core.
+	auto core = "C" + random_bases(1000000, 142) + "C";
+	auto other = core.substr(0, 3000) + core.substr(3003);
+	other[700000] = other[700000] == 'A' ? 'C' : 'A';
+
+	auto lhs_bases = telomeres(10) + core + telomeres(10);
+	auto rhs_bases = telomeres(13) + other + telomeres(10);
+	auto lhs = make_helix(lhs_bases, 512);
+	auto rhs = make_helix(rhs_bases, 512);
+	auto lhs_path = temp_path("sidecar_lhs.dnablk");
+	auto rhs_path = temp_path("sidecar_rhs.dnablk");
+	dna::write_block_sidecar(lhs, lhs_path);
+	dna::write_block_sidecar(rhs, rhs_path);
+
+	dna::block_sidecar lhs_sidecar(lhs_path);
+	dna::block_sidecar rhs_sidecar(rhs_path);
+	counting_stream lhs_counted(lhs);
+	counting_stream rhs_counted(rhs);
+
+	std::vector<dna::difference> found;
+	dna::compare_coarse(lhs_counted, rhs_counted, lhs_sidecar, rhs_sidecar, 0, dna::frame_helices(lhs, rhs),
+			[&](const dna::difference& d) { found.push_back(d); });
+
+	std::vector<dna::difference> expected;
+	auto map = dna::map_alignment(lhs, rhs, dna::frame_helices(lhs, rhs));
+	dna::compare_mapped(lhs, rhs, 0, map, [&](const dna::difference& d) { expected.push_back(d); });
+	REQUIRE(found == expected);
+	REQUIRE(found.size() == 2);
+
+	auto bases = lhs_bases.size() + rhs_bases.size();
+	REQUIRE(4 * (lhs_counted.bytes() + rhs_counted.bytes()) < bases / 10);
+
+	std::remove(lhs_path.c_str());
+	std::remove(rhs_path.c_str());
+}
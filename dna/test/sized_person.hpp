@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include "fake_stream.hpp"
+
+// A helix that only knows its size and counts how often it is read from.
+class sized_stream
+{
+	long size_;
+	std::shared_ptr<std::size_t> reads_;
+public:
+	sized_stream() :
+			size_(0),
+			reads_(std::make_shared<std::size_t>(0))
+	{ }
+
+	explicit sized_stream(long size) :
+			size_(size),
+			reads_(std::make_shared<std::size_t>(0))
+	{ }
+
+	void seek(long)
+	{ }
+
+	long size() const
+	{
+		return size_;
+	}
+
+	dna::sequence_buffer<fake_stream::byte_view> read()
+	{
+		++*reads_;
+		return fake_stream::byte_view(nullptr, 0);
+	}
+
+	std::size_t reads() const
+	{
+		return *reads_;
+	}
+};
+
+class sized_person
+{
+	std::array<sized_stream, 23> chroms_;
+public:
+	explicit sized_person(long sex_chromosome_bytes, long other_bytes = 64)
+	{
+		for (auto& chrom : chroms_)
+			chrom = sized_stream(other_bytes);
+		chroms_.back() = sized_stream(sex_chromosome_bytes);
+	}
+
+	const sized_stream& chromosome(std::size_t chromosome_index) const
+	{
+		return chroms_.at(chromosome_index);
+	}
+
+	constexpr std::size_t chromosomes() const
+	{
+		return chroms_.size();
+	}
+};
@@ -0,0 +1,75 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <cstdio>
+#include <sstream>
+#include <person_index.hpp>
+
+namespace
+{
+
+std::string reverse_complement(std::string bases)
+{
+	std::reverse(bases.begin(), bases.end());
+	for (auto& b : bases)
+		b = b == 'A' ? 'T' : b == 'T' ? 'A' : b == 'C' ? 'G' : 'C';
+	return bases;
+}
+
+dna::minhash_sketch sketch_of(const std::string& bases)
+{
+	auto helix = make_helix(bases);
+	return dna::sketch_helix(helix, 256);
+}
+
+}
+
+TEST_CASE("Sketches estimate shared k-mers", "[sketch]")
+{
+	auto bases = random_bases(20000, 110);
+	auto sketch = sketch_of(bases);
+
+	REQUIRE(sketch.hashes.size() == 256);
+	REQUIRE(std::is_sorted(sketch.hashes.begin(), sketch.hashes.end()));
+	REQUIRE(dna::jaccard_estimate(sketch, sketch) == 1.0);
+	REQUIRE(dna::jaccard_estimate(sketch, sketch_of(random_bases(20000, 111))) < 0.05);
+
+	auto half = bases.substr(0, 10000) + random_bases(10000, 112);
+	auto estimate = dna::jaccard_estimate(sketch, sketch_of(half));
+	REQUIRE(estimate > 0.2);
+	REQUIRE(estimate < 0.5);
+}
+
+TEST_CASE("Sketches use canonical k-mers", "[sketch]")
+{
+	auto bases = random_bases(8000, 113);
+	REQUIRE(dna::jaccard_estimate(sketch_of(bases), sketch_of(reverse_complement(bases))) > 0.95);
+}
+
+TEST_CASE("Sketches need at least one hash", "[sketch]")
+{
+	REQUIRE_THROWS_AS(dna::sketch_builder(0), std::invalid_argument);
+	REQUIRE(dna::sketch_builder(1).finish().hashes.empty());
+}
+
+TEST_CASE("Person index stores sketches", "[sketch]")
+{
+	std::vector<std::string> chromosomes;
+	for (unsigned i = 0; i < 23; ++i)
+		chromosomes.push_back(telomeres(4) + random_bases(1000 + 4 * i, 114 + i));
+	auto person = make_person(chromosomes);
+	auto index = dna::build_person_index(person, 4);
+	REQUIRE(index.sketches.size() == 23);
+
+	std::stringstream stream;
+	dna::write_person_index(index, stream);
+	auto loaded = dna::read_person_index(stream);
+	REQUIRE(loaded.sketches.size() == 23);
+	REQUIRE(loaded.sketches[1] == index.sketches[1]);
+
+	auto path = dna::index_path_for(temp_path("sketched_genome"));
+	dna::write_person_index(index, path);
+	REQUIRE(dna::read_index_sketch(path, 1) == index.sketches[1]);
+	REQUIRE(dna::read_index_entry(path, 1).size == index.chromosomes[1].size);
+
+	std::remove(path.c_str());
+}
@@ -0,0 +1,84 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <structural.hpp>
+
+namespace
+{
+
+std::string reverse_complement(std::string bases)
+{
+	std::reverse(bases.begin(), bases.end());
+	for (auto& b : bases)
+		b = b == 'A' ? 'T' : b == 'T' ? 'A' : b == 'C' ? 'G' : 'C';
+	return bases;
+}
+
+std::vector<dna::difference> structural(const std::string& lhs_core, const std::string& rhs_core)
+{
+	auto lhs = make_helix(telomeres(4) + lhs_core + telomeres(4), 4096);
+	auto rhs = make_helix(telomeres(4) + rhs_core + telomeres(4), 4096);
+	std::vector<dna::difference> found;
+	dna::compare_structural(lhs, rhs, 0, dna::frame_helices(lhs, rhs),
+			[&](const dna::difference& d) { found.push_back(d); });
+	return found;
+}
+
+}
+
+TEST_CASE("Reverse complement of a packed word", "[structural]")
+{
+	auto bases = random_bases(32, 230);
+	auto helix = make_helix(bases);
+	auto other = make_helix(reverse_complement(bases));
+	auto word = dna::load_packed(helix, 0, 32).word(0);
+	auto flipped = dna::load_packed(other, 0, 32).word(0);
+	REQUIRE(dna::reverse_complement(word) == flipped);
+	REQUIRE(dna::complement(dna::A) == dna::T);
+	REQUIRE(dna::complement(dna::C) == dna::G);
+}
+
+TEST_CASE("Large insertions past the resync range are found", "[structural]")
+{
+	auto core = "C" + random_bases(60000, 231);
+	auto inserted = core.substr(0, 20000) + random_bases(30000, 232) + core.substr(20000);
+
+	auto found = structural(core, inserted);
+	REQUIRE(found.size() == 1);
+	REQUIRE(found[0].kind == dna::difference_kind::insertion);
+	REQUIRE(found[0].length == 30000);
+	REQUIRE(found[0].start <= 20024);
+	REQUIRE(found[0].start + 4 >= 20024);
+}
+
+TEST_CASE("Large deletions past the resync range are found", "[structural]")
+{
+	auto core = "C" + random_bases(80000, 233);
+	auto deleted = core.substr(0, 20000) + core.substr(45000);
+
+	auto found = structural(core, deleted);
+	REQUIRE(found.size() == 1);
+	REQUIRE(found[0].kind == dna::difference_kind::deletion);
+	REQUIRE(found[0].length == 25000);
+	REQUIRE(found[0].start <= 20024);
+	REQUIRE(found[0].start + 4 >= 20024);
+}
+
+TEST_CASE("Inversions are reported as one record", "[structural]")
+{
+	auto core = "C" + random_bases(60000, 234);
+	for (std::size_t length : {std::size_t{2000}, std::size_t{9000}})
+	{
+		auto inverted = core.substr(0, 30000) + reverse_complement(core.substr(30000, length)) +
+				core.substr(30000 + length);
+		inverted[50000] = inverted[50000] == 'A' ? 'C' : 'A';
+
+		auto found = structural(core, inverted);
+		REQUIRE(found.size() == 2);
+		REQUIRE(found[0].kind == dna::difference_kind::inversion);
+		REQUIRE(found[0].start <= 30024);
+		REQUIRE(found[0].start + 4 >= 30024);
+		REQUIRE(found[0].end() + found[0].start == 2 * 30024 + length);
+		REQUIRE(found[1].kind == dna::difference_kind::substitution);
+		REQUIRE(found[1].start == 50024);
+	}
+}
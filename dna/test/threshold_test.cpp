@@ -0,0 +1,72 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <threshold.hpp>
+
+namespace
+{
+
+std::pair<fake_stream, fake_stream> diverged(std::size_t snps)
+{
+	auto core = random_bases(40000, 90);
+	auto other = core;
+	for (std::size_t i = 0; i < snps; ++i)
+		other[100 + i * 397] = other[100 + i * 397] == 'A' ? 'T' : 'A';
+	other = other.substr(0, 20000) + "TTGCA" + other.substr(20000);
+
+	return {make_helix(telomeres(10) + core + telomeres(10), 256),
+			make_helix(telomeres(10) + other + telomeres(10), 256)};
+}
+
+}
+
+TEST_CASE("Bounded comparison stops once the threshold is passed", "[threshold]")
+{
+	auto helices = diverged(100);
+	auto frame = dna::frame_helices(helices.first, helices.second);
+
+	auto result = dna::compare_bounded(helices.first, helices.second, frame, 0, 10, 4, 8192, 1024);
+	REQUIRE(result.exceeded);
+	REQUIRE(result.mismatches > 10);
+	REQUIRE(result.compared < 40000);
+}
+
+TEST_CASE("Bounded comparison finishes when the threshold is not reached", "[threshold]")
+{
+	auto helices = diverged(30);
+	auto frame = dna::frame_helices(helices.first, helices.second);
+
+	auto result = dna::compare_bounded(helices.first, helices.second, frame, 0, 40, 4, 8192, 1024);
+	REQUIRE_FALSE(result.exceeded);
+	REQUIRE(result.mismatches == 35);
+	REQUIRE(result.compared == 40000);
+
+	auto exact = dna::compare_bounded(helices.first, helices.second, frame, 0, 35, 4, 8192, 1024);
+	REQUIRE_FALSE(exact.exceeded);
+
+	auto passed = dna::compare_bounded(helices.first, helices.second, frame, 0, 34, 4, 8192, 1024);
+	REQUIRE(passed.exceeded);
+}
+
+TEST_CASE("Shards that drifted past the seed search start from the previous shard", "[threshold]")
+{
+	auto core = random_bases(40000, 91);
+	auto other = core;
+	for (std::size_t i = 0; i < 20; ++i)
+		other[9000 + i * 1500] = other[9000 + i * 1500] == 'A' ? 'T' : 'A';
+	other = other.substr(0, 1000) + random_bases(12000, 92) + other.substr(1000, 2000) + random_bases(12000, 93) +
+			other.substr(3000, 2000) + random_bases(12000, 94) + other.substr(5000);
+
+	auto lhs = make_helix(telomeres(10) + core + telomeres(10), 256);
+	auto rhs = make_helix(telomeres(10) + other + telomeres(10), 256);
+	auto frame = dna::frame_helices(lhs, rhs);
+
+	std::size_t expected = 0;
+	dna::compare_mapped(lhs, rhs, 0, dna::map_alignment(lhs, rhs, frame),
+			[&](const dna::difference& d) { expected += d.length; });
+	REQUIRE(expected == 36020);
+
+	auto result = dna::compare_bounded(lhs, rhs, frame, 0, expected, 4, 8192, 1024);
+	REQUIRE_FALSE(result.exceeded);
+	REQUIRE(result.mismatches == expected);
+	REQUIRE(result.compared == 40000);
+}
@@ -0,0 +1,50 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <top_windows.hpp>
+
+TEST_CASE("Window counter splits differences across windows", "[top]")
+{
+	using dna::difference_kind;
+	dna::window_heap heap(10);
+	dna::window_counter counter(heap, 0, 100);
+
+	counter(dna::difference{0, 10, 1, 10, difference_kind::substitution, 0});
+	counter(dna::difference{0, 95, 10, 95, difference_kind::deletion, 0});
+	counter(dna::difference{0, 350, 4, 350, difference_kind::insertion, 0});
+	counter.flush();
+
+	auto top = std::move(heap).sorted();
+	REQUIRE(top.size() == 3);
+	REQUIRE(top[0].start == 0);
+	REQUIRE(top[0].mismatches == 6);
+	REQUIRE(top[1].start == 100);
+	REQUIRE(top[1].mismatches == 5);
+	REQUIRE(top[2].start == 300);
+}
+
+TEST_CASE("Top divergent windows across people", "[top]")
+{
+	std::vector<std::string> lhs_bases;
+	std::vector<std::string> rhs_bases;
+	for (unsigned c = 0; c < 23; ++c)
+	{
+		auto core = "C" + random_bases(4000, 200 + c);
+		auto other = core;
+		auto hits = c == 4 ? 9u : c == 11 ? 5u : c == 17 ? 1u : 0u;
+		for (unsigned h = 0; h < hits; ++h)
+			other[100 + 150 * h] = other[100 + 150 * h] == 'A' ? 'C' : 'A';
+		other[3500] = c == 11 ? (other[3500] == 'A' ? 'C' : 'A') : other[3500];
+
+		lhs_bases.push_back(telomeres(4) + core + telomeres(4));
+		rhs_bases.push_back(telomeres(4) + other + telomeres(4));
+	}
+
+	auto top = dna::top_divergent_windows(make_person(lhs_bases), make_person(rhs_bases), 3, 2000, 4);
+	REQUIRE(top.size() == 3);
+	REQUIRE(top[0].chromosome == 4);
+	REQUIRE(top[0].mismatches == 9);
+	REQUIRE(top[1].chromosome == 11);
+	REQUIRE(top[1].mismatches == 5);
+	REQUIRE(top[2].chromosome == 11);
+	REQUIRE(top[2].mismatches == 1);
+}
@@ -0,0 +1,146 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <cstdio>
+#include <variant_compare.hpp>
+
+namespace
+{
+
+std::string mutate(std::string bases, std::size_t first, std::size_t step)
+{
+	for (auto i = first; i < bases.size(); i += step)
+		bases[i] = bases[i] == 'G' ? 'C' : 'G';
+	return bases;
+}
+
+std::vector<std::string> genome(const std::string& body, std::size_t head)
+{
+	std::vector<std::string> result;
+	for (unsigned c = 0; c < 23; ++c)
+		result.push_back(telomeres(head) + body + telomeres(4));
+	return result;
+}
+
+// Derives a pair from stored lists the way compare_chromosome_by_variants
+// does, counting the lhs bases handed to the engine.
+std::vector<dna::difference> derive(const fake_person& lhs, const dna::difference_store& lhs_store,
+		const fake_person& rhs, const dna::difference_store& rhs_store, const fake_person& reference,
+		std::size_t chromosome, std::size_t& engine_bases)
+{
+	auto reference_helix = reference.chromosome(chromosome);
+	auto lhs_helix = lhs.chromosome(chromosome);
+	auto rhs_helix = rhs.chromosome(chromosome);
+	auto lhs_shift = dna::frame_helices(reference_helix, lhs_helix).offset();
+	auto rhs_shift = dna::frame_helices(reference_helix, rhs_helix).offset();
+
+	engine_bases = 0;
+	return dna::compare_variant_lists(dna::stored_variants(lhs_store, chromosome), lhs_shift,
+			dna::stored_variants(rhs_store, chromosome), rhs_shift, reference_helix, chromosome,
+			[&](const dna::alignment_frame& window, auto& emit)
+			{
+				engine_bases += window.lhs_end - window.lhs_begin;
+				auto map = dna::map_alignment(lhs_helix, rhs_helix, window);
+				dna::compare_mapped(lhs_helix, rhs_helix, chromosome, map, emit);
+			});
+}
+
+}
+
+TEST_CASE("Variant lists reproduce the engine", "[variants]")
+{
+	auto body = "C" + random_bases(6000, 190);
+	auto lhs_body = mutate(mutate(body, 100, 400), 2500, 1000);
+	auto rhs_body = mutate(mutate(body, 300, 400), 2500, 1000);
+	rhs_body[4500] = rhs_body[4500] == 'A' ? 'T' : 'A';
+	rhs_body[4501] = rhs_body[4501] == 'A' ? 'T' : 'A';
+
+	auto reference = make_person(genome(body, 4));
+	auto lhs = make_person(genome(lhs_body, 6));
+	auto rhs = make_person(genome(rhs_body, 9));
+
+	auto lhs_path = temp_path("variants_lhs.dnadif");
+	auto rhs_path = temp_path("variants_rhs.dnadif");
+	dna::write_difference_store(dna::compare_chromosome(reference, lhs, 5), lhs_path);
+	dna::write_difference_store(dna::compare_chromosome(reference, rhs, 5), rhs_path);
+
+	{
+		dna::difference_store lhs_store(lhs_path);
+		dna::difference_store rhs_store(rhs_path);
+
+		std::size_t engine_bases = 0;
+		REQUIRE(derive(lhs, lhs_store, rhs, rhs_store, reference, 5, engine_bases) == dna::compare_chromosome(lhs, rhs, 5));
+		REQUIRE(engine_bases == 0);
+	}
+
+	std::remove(lhs_path.c_str());
+	std::remove(rhs_path.c_str());
+}
+
+TEST_CASE("Variant lists carry coordinates across indels", "[variants]")
+{
+	// A shared insertion cancels out. Only the windows around the lhs-only
+	// deletion and around a cluster the refiner would realign go to the
+	// engine; the substitutions on either side of both come from the lists
+	// under the shifts the indels leave.
+	auto body = "C" + random_bases(120000, 191);
+	auto shared = body.substr(0, 20000) + "TTTAC" + body.substr(20000);
+	auto lhs_body = mutate(shared.substr(0, 60000) + shared.substr(60012), 100, 700);
+	auto rhs_body = mutate(shared, 350, 900);
+	for (std::size_t i = 90000; i < 90040; i += 5)
+		rhs_body[i] = rhs_body[i] == 'A' ? 'T' : 'A';
+
+	auto reference = make_person(genome(body, 4));
+	auto lhs = make_person(genome(lhs_body, 5));
+	auto rhs = make_person(genome(rhs_body, 7));
+
+	auto lhs_path = temp_path("shifted_lhs.dnadif");
+	auto rhs_path = temp_path("shifted_rhs.dnadif");
+	dna::write_difference_store(dna::compare_chromosome(reference, lhs, 2), lhs_path);
+	dna::write_difference_store(dna::compare_chromosome(reference, rhs, 2), rhs_path);
+
+	{
+		dna::difference_store lhs_store(lhs_path);
+		dna::difference_store rhs_store(rhs_path);
+
+		auto expected = dna::compare_chromosome(lhs, rhs, 2);
+		REQUIRE(expected.size() > 200);
+		std::size_t engine_bases = 0;
+		REQUIRE(derive(lhs, lhs_store, rhs, rhs_store, reference, 2, engine_bases) == expected);
+		REQUIRE(engine_bases > 2 * dna::variant_margin_bases + 12);
+		REQUIRE(engine_bases <= 4 * dna::variant_margin_bases + 64);
+		REQUIRE(dna::compare_chromosome_by_variants(lhs, lhs_store, rhs, rhs_store, reference, 2) == expected);
+	}
+
+	std::remove(lhs_path.c_str());
+	std::remove(rhs_path.c_str());
+}
+
+TEST_CASE("Variant lists hand unshared indels to the engine", "[variants]")
+{
+	auto body = "C" + random_bases(6000, 191);
+	auto lhs_body = mutate(body, 100, 700);
+	auto rhs_body = body.substr(0, 3000) + "TTTAC" + body.substr(3000);
+
+	auto reference = make_person(genome(body, 4));
+	auto lhs = make_person(genome(lhs_body, 4));
+	auto rhs = make_person(genome(rhs_body, 4));
+
+	auto lhs_path = temp_path("fallback_lhs.dnadif");
+	auto rhs_path = temp_path("fallback_rhs.dnadif");
+	dna::write_difference_store(dna::compare_chromosome(reference, lhs, 2), lhs_path);
+	dna::write_difference_store(dna::compare_chromosome(reference, rhs, 2), rhs_path);
+
+	{
+		dna::difference_store lhs_store(lhs_path);
+		dna::difference_store rhs_store(rhs_path);
+
+		std::size_t engine_bases = 0;
+		REQUIRE(derive(lhs, lhs_store, rhs, rhs_store, reference, 2, engine_bases) == dna::compare_chromosome(lhs, rhs, 2));
+		REQUIRE(engine_bases > 0);
+		REQUIRE(dna::compare_chromosome_by_variants(lhs, lhs_store, rhs, rhs_store, reference, 2) ==
+				dna::compare_chromosome(lhs, rhs, 2));
+	}
+
+	std::remove(lhs_path.c_str());
+	std::remove(rhs_path.c_str());
+}
@@ -0,0 +1,122 @@
+#include "catch.hpp"
+#include "sequences.hpp"
+#include <cstdio>
+#include <random>
+#include <variant_index.hpp>
+
+TEST_CASE("Posting lists switch containers and combine", "[postings]")
+{
+	dna::posting_list evens;
+	dna::posting_list sevenths;
+	for (std::uint32_t id = 0; id < 150000; ++id)
+	{
+		if (id % 2 == 0)
+			evens.push_back(id);
+		if (id % 7 == 0 && id < 20000)
+			sevenths.push_back(id);
+	}
+
+	REQUIRE(evens.size() == 75000);
+	REQUIRE(evens.containers()[0].is_bitmap());
+	REQUIRE_FALSE(sevenths.containers()[0].is_bitmap());
+	REQUIRE(evens.contains(149998));
+	REQUIRE_FALSE(evens.contains(149999));
+
+	auto both = evens & sevenths;
+	REQUIRE(both.size() == 1429);
+	REQUIRE(both.ids()[1] == 14);
+
+	auto either = evens | sevenths;
+	REQUIRE(either.size() == 75000 + 2858 - 1429);
+	REQUIRE(either.contains(7));
+	REQUIRE_FALSE(either.contains(20001));
+}
+
+TEST_CASE("Posting lists reject ids out of order", "[postings]")
+{
+	dna::posting_list ids;
+	ids.push_back(5);
+	ids.push_back(70000);
+	REQUIRE_THROWS_AS(ids.push_back(70000), std::invalid_argument);
+	REQUIRE_THROWS_AS(ids.push_back(6), std::invalid_argument);
+	REQUIRE(ids.size() == 2);
+
+	// Set results carry on from their highest id, bitmaps included.
+	dna::posting_list evens;
+	for (std::uint32_t id = 0; id < 20000; id += 2)
+		evens.push_back(id);
+	auto either = evens | ids;
+	REQUIRE_THROWS_AS(either.push_back(69999), std::invalid_argument);
+	either.push_back(70001);
+	auto both = evens & evens;
+	REQUIRE(both.containers()[0].is_bitmap());
+	REQUIRE_THROWS_AS(both.push_back(19998), std::invalid_argument);
+	both.push_back(19999);
+	REQUIRE(both.contains(19999));
+}
+
+TEST_CASE("Variant index lists carriers from stored differences", "[postings]")
+{
+	using dna::difference_kind;
+	dna::difference shared{2, 500, 1, 500, difference_kind::substitution, dna::base_word(dna::G, 0)};
+	dna::difference other_allele{2, 500, 1, 500, difference_kind::substitution, dna::base_word(dna::T, 0)};
+	dna::difference deletion{4, 900, 3, 900, difference_kind::deletion, 0};
+
+	auto first_path = temp_path("carrier_0.dnadif");
+	auto second_path = temp_path("carrier_1.dnadif");
+	auto third_path = temp_path("carrier_2.dnadif");
+	dna::write_difference_store({shared, deletion}, first_path, 2);
+	dna::write_difference_store({other_allele}, second_path, 2);
+	dna::write_difference_store({shared}, third_path, 2);
+
+	{
+		dna::difference_store first(first_path);
+		dna::difference_store second(second_path);
+		dna::difference_store third(third_path);
+		auto index = dna::build_variant_index({first, second, third}, 3);
+
+		REQUIRE(index.size() == 3);
+		REQUIRE(index.carriers(dna::variant{2, 500, 1, difference_kind::substitution, dna::base_word(dna::G, 0)}).ids() ==
+				std::vector<std::uint32_t>{0, 2});
+		REQUIRE(index.carriers(dna::variant{2, 500, 1, difference_kind::substitution, dna::base_word(dna::T, 0)}).ids() ==
+				std::vector<std::uint32_t>{1});
+		REQUIRE(index.carriers(dna::variant{4, 900, 3, difference_kind::deletion, 0}).ids() == std::vector<std::uint32_t>{0});
+		REQUIRE(index.carriers_at(2, 500).size() == 3);
+		REQUIRE(index.carriers_at(2, 501).empty());
+	}
+
+	std::remove(first_path.c_str());
+	std::remove(second_path.c_str());
+	std::remove(third_path.c_str());
+}
+
+TEST_CASE("Variant index keys a substitution run per base", "[postings]")
+{
+	using dna::difference_kind;
+	auto run_alternate = dna::base_word(dna::C, 0) | dna::base_word(dna::G, 1) | dna::base_word(dna::T, 2);
+	dna::difference run{1, 100, 3, 100, difference_kind::substitution, run_alternate};
+	dna::difference lone{1, 101, 1, 101, difference_kind::substitution, dna::base_word(dna::G, 0)};
+	dna::difference insertion{1, 101, 2, 99, difference_kind::insertion, dna::base_word(dna::A, 0)};
+
+	auto run_path = temp_path("run.dnadif");
+	auto lone_path = temp_path("lone.dnadif");
+	dna::write_difference_store({run}, run_path, 2);
+	dna::write_difference_store({insertion, lone}, lone_path, 2);
+
+	{
+		dna::difference_store with_run(run_path);
+		dna::difference_store with_lone(lone_path);
+		auto index = dna::build_variant_index({with_run, with_lone}, 2);
+
+		REQUIRE(index.size() == 4);
+		REQUIRE(index.carriers(dna::variant{1, 101, 1, difference_kind::substitution, dna::base_word(dna::G, 0)}).ids() ==
+				std::vector<std::uint32_t>{0, 1});
+		REQUIRE(index.carriers(dna::variant{1, 102, 1, difference_kind::substitution, dna::base_word(dna::T, 0)}).ids() ==
+				std::vector<std::uint32_t>{0});
+		REQUIRE(index.carriers_at(1, 101).ids() == std::vector<std::uint32_t>{0, 1});
+		REQUIRE(index.carriers_at(1, 100).ids() == std::vector<std::uint32_t>{0});
+	}
+
+	std::remove(run_path.c_str());
+	std::remove(lone_path.c_str());
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "cohort.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t threshold_shard_bases = std::size_t{1} << 22;
+static constexpr std::size_t threshold_chunk_bases = std::size_t{1} << 16;
+
+// `mismatches` only counts what was compared before the shards stopped, so
+// it is exact only when the whole range was compared.
+struct threshold_result
+{
+	bool exceeded;
+	std::size_t mismatches;
+	std::size_t compared;
+};
+
+namespace detail
+{
+
+// Helix pairs lent to shards. Shards only seek and read, so a worker hands
+// its pair back for the next shard instead of every shard copying both
+// helices; at most one pair per worker is ever made.
+template<HelixStream S>
+class helix_pool
+{
+	const S& lhs_;
+	const S& rhs_;
+	std::mutex lock_;
+	std::vector<std::unique_ptr<std::pair<S, S>>> free_;
+public:
+	helix_pool(const S& lhs, const S& rhs) :
+			lhs_(lhs),
+			rhs_(rhs),
+			lock_(),
+			free_()
+	{ }
+
+	std::unique_ptr<std::pair<S, S>> acquire()
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (free_.empty())
+			return std::make_unique<std::pair<S, S>>(lhs_, rhs_);
+
+		auto helices = std::move(free_.back());
+		free_.pop_back();
+		return helices;
+	}
+
+	void release(std::unique_ptr<std::pair<S, S>> helices)
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		free_.push_back(std::move(helices));
+	}
+};
+
+}
+
+// Counts differing bases across independent shards and stops every shard as
+// soon as the count passes `threshold`. Only passing it stops early: any
+// remaining base may still hide an indel, so a sound "can't be reached"
+// bound stays near twice the bases left until the very end and would never
+// save any work. Each shard finds its own offset with seed anchors, so
+// shards stay independent even after indels. A shard whose seeds find no
+// offset is never compared at a guess: it waits until the shards before it
+// are done and then starts from the offset the previous one ended on.
+template<HelixStream S>
+threshold_result compare_bounded(const S& lhs, const S& rhs, const alignment_frame& frame, std::size_t chromosome,
+		std::size_t threshold, std::size_t threads = default_threads(),
+		std::size_t shard_bases = threshold_shard_bases, std::size_t chunk_bases = threshold_chunk_bases)
+{
+	auto lhs_length = frame.lhs_end > frame.lhs_begin ? frame.lhs_end - frame.lhs_begin : 0;
+
+	std::atomic<std::size_t> mismatches{0};
+	std::atomic<std::size_t> compared{0};
+	std::atomic<bool> stop{false};
+	detail::helix_pool<S> pool(lhs, rhs);
+
+	auto shards = (lhs_length + shard_bases - 1) / shard_bases;
+	std::vector<std::optional<long>> ends(shards);
+
+	auto run = [&](std::size_t shard, S& query, S& target, long offset)
+	{
+		auto begin = frame.lhs_begin + shard * shard_bases;
+		auto end = std::min(frame.lhs_end, begin + shard_bases);
+		alignment_frame shard_frame{begin, static_cast<std::size_t>(std::max(0L, static_cast<long>(begin) + offset)),
+				end, frame.rhs_end};
+		detail::lockstep_target<S&> lane(query, target, chromosome, shard_frame);
+
+		std::size_t found = 0;
+		auto count = [&](const difference& d) { found += d.length; };
+
+		for (auto position = begin; position < end && !stop; position += chunk_bases)
+		{
+			auto length = std::min(chunk_bases, end - position);
+			lane.advance(load_packed(query, position, length), position, count);
+
+			compared += length;
+			if ((mismatches += found) > threshold)
+				stop = true;
+			found = 0;
+		}
+
+		if (!stop)
+		{
+			lane.finish(count);
+			if ((mismatches += found) > threshold)
+				stop = true;
+		}
+		ends[shard] = lane.offset();
+	};
+
+	std::vector<std::size_t> unresolved;
+	std::mutex unresolved_lock;
+	parallel_for(shards, threads, [&](std::size_t shard)
+	{
+		if (stop)
+			return;
+
+		auto helices = pool.acquire();
+		auto& [query, target] = *helices;
+		auto offset = shard == 0 ? std::optional<long>(frame.offset()) :
+				detail::locate_offset(query, target, frame.lhs_begin + shard * shard_bases, frame.offset(), frame.rhs_end);
+
+		if (offset)
+			run(shard, query, target, *offset);
+		else
+		{
+			std::lock_guard<std::mutex> guard(unresolved_lock);
+			unresolved.push_back(shard);
+		}
+		pool.release(std::move(helices));
+	});
+
+	std::sort(unresolved.begin(), unresolved.end());
+	for (auto shard : unresolved)
+	{
+		if (stop)
+			break;
+
+		auto helices = pool.acquire();
+		run(shard, helices->first, helices->second, *ends[shard - 1]);
+		pool.release(std::move(helices));
+	}
+
+	auto total = mismatches.load();
+	return threshold_result{total > threshold, total, compared.load()};
+}
+
+template<Person P>
+threshold_result exceeds_threshold(const P& lhs, const P& rhs, std::size_t chromosome, std::size_t threshold,
+		std::size_t threads = default_threads())
+{
+	helix_of<P> lhs_helix = lhs.chromosome(chromosome);
+	helix_of<P> rhs_helix = rhs.chromosome(chromosome);
+	auto frame = frame_helices(lhs_helix, rhs_helix);
+
+	return compare_bounded(lhs_helix, rhs_helix, frame, chromosome, threshold, threads);
+}
+
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <queue>
+#include "engine.hpp"
+
+namespace dna
+{
+
+static constexpr std::size_t divergence_window_bases = 10000;
+
+struct window_divergence
+{
+	std::size_t chromosome;
+	std::size_t start;
+	std::size_t length;
+	std::size_t mismatches;
+};
+
+// Most divergent first; ties go to the earlier window.
+constexpr bool more_divergent(const window_divergence& lhs, const window_divergence& rhs) noexcept
+{
+	if (lhs.mismatches != rhs.mismatches)
+		return lhs.mismatches > rhs.mismatches;
+	if (lhs.chromosome != rhs.chromosome)
+		return lhs.chromosome < rhs.chromosome;
+	return lhs.start < rhs.start;
+}
+
+// Keeps the k most divergent windows seen, the weakest on top of the heap.
+class window_heap
+{
+	struct weaker
+	{
+		bool operator()(const window_divergence& lhs, const window_divergence& rhs) const noexcept
+		{
+			return more_divergent(lhs, rhs);
+		}
+	};
+
+	std::size_t k_;
+	std::priority_queue<window_divergence, std::vector<window_divergence>, weaker> heap_;
+public:
+	explicit window_heap(std::size_t k) :
+			k_(k),
+			heap_()
+	{ }
+
+	void push(const window_divergence& window)
+	{
+		if (k_ == 0 || window.mismatches == 0)
+			return;
+		if (heap_.size() < k_)
+			heap_.push(window);
+		else if (more_divergent(window, heap_.top()))
+		{
+			heap_.pop();
+			heap_.push(window);
+		}
+	}
+
+	void merge(window_heap&& other)
+	{
+		while (!other.heap_.empty())
+		{
+			push(other.heap_.top());
+			other.heap_.pop();
+		}
+	}
+
+	std::vector<window_divergence> sorted() &&
+	{
+		std::vector<window_divergence> result;
+		while (!heap_.empty())
+		{
+			result.push_back(heap_.top());
+			heap_.pop();
+		}
+		std::reverse(result.begin(), result.end());
+		return result;
+	}
+};
+
+// Engine sink: differences of one chromosome arrive in order and only the
+// current window's count is held, finished windows go straight to the heap.
+class window_counter
+{
+	window_heap& heap_;
+	std::size_t chromosome_;
+	std::size_t window_bases_;
+	std::size_t window_;
+	std::size_t count_;
+
+	void close()
+	{
+		heap_.push(window_divergence{chromosome_, window_ * window_bases_, window_bases_, count_});
+		count_ = 0;
+	}
+
+	void add(std::size_t position, std::size_t bases)
+	{
+		auto window = position / window_bases_;
+		if (window != window_)
+		{
+			close();
+			window_ = window;
+		}
+		count_ += bases;
+	}
+public:
+	window_counter(window_heap& heap, std::size_t chromosome, std::size_t window_bases = divergence_window_bases) :
+			heap_(heap),
+			chromosome_(chromosome),
+			window_bases_(window_bases),
+			window_(0),
+			count_(0)
+	{ }
+
+	void operator()(const difference& found)
+	{
+		if (found.kind == difference_kind::insertion)
+		{
+			add(found.start, found.length);
+			return;
+		}
+
+		for (auto position = found.start; position < found.end();)
+		{
+			auto stop = std::min(found.end(), (position / window_bases_ + 1) * window_bases_);
+			add(position, stop - position);
+			position = stop;
+		}
+	}
+
+	void flush()
+	{
+		close();
+	}
+};
+
+// One heap of k per chromosome task, merged once all are done, so nothing
+// per window is ever kept beyond the k best.
+template<Person P>
+std::vector<window_divergence> top_divergent_windows(const P& lhs, const P& rhs, std::size_t k = 100,
+		std::size_t window_bases = divergence_window_bases, std::size_t threads = default_threads())
+{
+	auto chromosomes = comparable_chromosomes(lhs, rhs);
+	std::vector<window_heap> heaps(chromosomes.size(), window_heap(k));
+
+	parallel_for(chromosomes.size(), threads, [&](std::size_t i)
+	{
+		helix_of<P> lhs_helix = lhs.chromosome(chromosomes[i]);
+		helix_of<P> rhs_helix = rhs.chromosome(chromosomes[i]);
+		auto map = map_alignment(lhs_helix, rhs_helix, frame_helices(lhs_helix, rhs_helix));
+
+		window_counter counter(heaps[i], chromosomes[i], window_bases);
+		compare_mapped(lhs_helix, rhs_helix, chromosomes[i], map, counter);
+		counter.flush();
+	});
+
+	window_heap result(k);
+	for (auto& heap : heaps)
+		result.merge(std::move(heap));
+	return std::move(result).sorted();
+}
+
+}
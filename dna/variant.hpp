@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <tuple>
+#include "difference.hpp"
+
+namespace dna
+{
+
+// A difference against a shared reference, keyed by where it sits and what
+// it changes to. Two people carrying equal variants agree there.
+struct variant
+{
+	std::size_t chromosome;
+	std::size_t position;
+	std::size_t length;
+	difference_kind kind;
+	packed_word alternate;
+};
+
+// Calls f with each allele `found` carries. A substitution run is one
+// single-base allele per base, so a SNP gets the same key whether or not it
+// has neighbours; bases past the 32 a run keeps are one allele of unknown
+// bases. Indels and inversions are one allele keyed at their start.
+template<typename F>
+void for_each_allele(const difference& found, F&& f)
+{
+	if (found.kind != difference_kind::substitution)
+	{
+		f(variant{found.chromosome, found.start, found.length, found.kind, found.alternate});
+		return;
+	}
+
+	auto known = std::min(found.length, word_bases);
+	for (std::size_t i = 0; i < known; ++i)
+		f(variant{found.chromosome, found.start + i, 1, found.kind, base_word(base_at(found.alternate, i), 0)});
+	if (found.length > known)
+		f(variant{found.chromosome, found.start + known, found.length - known, found.kind, 0});
+}
+
+constexpr bool operator==(const variant& lhs, const variant& rhs) noexcept
+{
+	return lhs.chromosome == rhs.chromosome && lhs.position == rhs.position && lhs.length == rhs.length &&
+			lhs.kind == rhs.kind && lhs.alternate == rhs.alternate;
+}
+
+constexpr bool operator!=(const variant& lhs, const variant& rhs) noexcept
+{
+	return !(lhs == rhs);
+}
+
+inline bool operator<(const variant& lhs, const variant& rhs) noexcept
+{
+	return std::tie(lhs.chromosome, lhs.position, lhs.kind, lhs.length, lhs.alternate) <
+			std::tie(rhs.chromosome, rhs.position, rhs.kind, rhs.length, rhs.alternate);
+}
+
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <limits>
+#include "difference_store.hpp"
+#include "engine.hpp"
+
+namespace dna
+{
+
+// Bases of engine context kept on each side of whatever the variant lists
+// can't settle.
+static constexpr std::size_t variant_margin_bases = resync_window_bases;
+
+namespace detail
+{
+
+// Where one person's bases sit against the reference, walked across the
+// indels of the person's sorted variant list the way map_alignment's
+// segments carry the offset: each indel moves the rhs - lhs shift for the
+// reference bases after it.
+class shift_walk
+{
+	struct step
+	{
+		std::size_t position;
+		long shift;
+	};
+
+	std::vector<step> steps_;
+public:
+	shift_walk(const std::vector<difference>& variants, long shift) :
+			steps_{step{0, shift}}
+	{
+		for (const auto& found : variants)
+		{
+			auto own = static_cast<long>(found.other_start) - static_cast<long>(found.start);
+			auto length = static_cast<long>(found.length);
+			if (found.kind == difference_kind::insertion)
+				steps_.push_back(step{found.start, own + length});
+			else if (found.kind == difference_kind::deletion)
+				steps_.push_back(step{found.end(), own - length});
+		}
+		std::stable_sort(steps_.begin(), steps_.end(),
+				[](const step& lhs, const step& rhs) { return lhs.position < rhs.position; });
+	}
+
+	// The person's base lined up with reference base `position`.
+	std::size_t at(std::size_t position) const noexcept
+	{
+		auto next = std::upper_bound(steps_.begin(), steps_.end(), position,
+				[](std::size_t wanted, const step& each) { return wanted < each.position; });
+		return static_cast<std::size_t>(std::max(0L, static_cast<long>(position) + std::prev(next)->shift));
+	}
+};
+
+// Reference bases [from, to) left to the engine.
+struct variant_window
+{
+	std::size_t from;
+	std::size_t to;
+};
+
+inline bool same_event(const difference& lhs, const difference& rhs) noexcept
+{
+	return lhs.start == rhs.start && lhs.length == rhs.length && lhs.kind == rhs.kind && lhs.alternate == rhs.alternate;
+}
+
+// The reference bases neither list settles on its own: an indel the other
+// list doesn't carry identically, which shifts one person against the other,
+// and substitution runs too long to replay from their stored bases.
+inline std::vector<variant_window> unresolved_spans(const std::vector<difference>& lhs,
+		const std::vector<difference>& rhs)
+{
+	std::vector<variant_window> result;
+	auto own = [&](const std::vector<difference>& list, const std::vector<difference>& other)
+	{
+		for (const auto& found : list)
+		{
+			if (found.kind == difference_kind::substitution)
+			{
+				if (found.length > word_bases)
+					result.push_back(variant_window{found.start, found.end()});
+				continue;
+			}
+
+			auto match = std::lower_bound(other.begin(), other.end(), found.start,
+					[](const difference& each, std::size_t wanted) { return each.start < wanted; });
+			bool shared = false;
+			for (; match != other.end() && match->start == found.start; ++match)
+				shared = shared || same_event(*match, found);
+			if (!shared)
+				result.push_back(variant_window{found.start, std::max(found.end(), found.start + 1)});
+		}
+	};
+	own(lhs, rhs);
+	own(rhs, lhs);
+	return result;
+}
+
+// Widens each span by the engine margin and merges the ones that meet.
+inline std::vector<variant_window> merge_windows(std::vector<variant_window> spans)
+{
+	std::sort(spans.begin(), spans.end(),
+			[](const variant_window& lhs, const variant_window& rhs) { return lhs.from < rhs.from; });
+
+	std::vector<variant_window> result;
+	for (const auto& span : spans)
+	{
+		variant_window widened{span.from - std::min(span.from, variant_margin_bases), span.to + variant_margin_bases};
+		if (!result.empty() && widened.from <= result.back().to)
+			result.back().to = std::max(result.back().to, widened.to);
+		else
+			result.push_back(widened);
+	}
+	return result;
+}
+
+struct variant_base
+{
+	std::size_t position;
+	base value;
+};
+
+// The substitutions of a list base by base, leaving out the bases inside
+// `windows` and the runs unresolved_spans leaves to the engine.
+inline std::vector<variant_base> variant_bases(const std::vector<difference>& variants,
+		const std::vector<variant_window>& windows)
+{
+	std::vector<variant_base> result;
+	auto window = windows.begin();
+	for (const auto& found : variants)
+	{
+		if (found.kind != difference_kind::substitution || found.length > word_bases)
+			continue;
+		for (std::size_t i = 0; i < found.length; ++i)
+		{
+			auto position = found.start + i;
+			while (window != windows.end() && window->to <= position)
+				++window;
+			if (window == windows.end() || position < window->from)
+				result.push_back(variant_base{position, base_at(found.alternate, i)});
+		}
+	}
+	return result;
+}
+
+}
+
+// Pairwise differences of two people from their sorted variant lists against
+// the same reference (the reference being the lhs of both), in the
+// coordinates the full engine would use. `lhs_shift` and `rhs_shift` are the
+// frame offsets the two lists were compared under. Coordinates are carried
+// across each list's indels piecewise; an indel both lists share identically
+// cancels out. Around what the lists can't settle, an indel only one of them
+// carries, a substitution run too long to replay or a cluster the refiner
+// would realign, resolve(frame, emit) compares the two people with the
+// engine over `variant_margin_bases` either side, and everything else comes
+// from the lists alone. The reference is only read where the lhs carries a
+// substitution the rhs lacks.
+template<HelixStream S, typename R>
+std::vector<difference> compare_variant_lists(const std::vector<difference>& lhs, long lhs_shift,
+		const std::vector<difference>& rhs, long rhs_shift, S& reference, std::size_t chromosome, R&& resolve)
+{
+	detail::shift_walk lhs_walk(lhs, lhs_shift);
+	detail::shift_walk rhs_walk(rhs, rhs_shift);
+
+	packed_sequence window;
+	std::size_t window_start = 0;
+	auto reference_at = [&](std::size_t position)
+	{
+		if (position < window_start || position >= window_start + window.size())
+		{
+			window_start = position;
+			window = load_packed(reference, position, resync_window_bases);
+		}
+		return window.at(position - window_start);
+	};
+
+	// Substitutions outside `windows`, each with the reference base it starts on.
+	std::vector<difference> derived;
+	std::vector<std::size_t> origins;
+	auto derive = [&](const std::vector<detail::variant_window>& windows)
+	{
+		derived.clear();
+		origins.clear();
+		std::vector<std::pair<std::size_t, std::size_t>> starts;
+		difference_coalescer coalescer;
+		auto emit = [&](const difference& found) { derived.push_back(found); };
+		auto report = [&](std::size_t position, base value)
+		{
+			starts.emplace_back(lhs_walk.at(position), position);
+			coalescer.push(difference{chromosome, lhs_walk.at(position), 1, rhs_walk.at(position),
+					difference_kind::substitution, base_word(value, 0)}, emit);
+		};
+
+		auto lhs_bases = detail::variant_bases(lhs, windows);
+		auto rhs_bases = detail::variant_bases(rhs, windows);
+		auto l = lhs_bases.begin();
+		auto r = rhs_bases.begin();
+		while (l != lhs_bases.end() || r != rhs_bases.end())
+		{
+			if (r == rhs_bases.end() || (l != lhs_bases.end() && l->position < r->position))
+			{
+				report(l->position, reference_at(l->position));
+				++l;
+			}
+			else if (l == lhs_bases.end() || r->position < l->position)
+			{
+				report(r->position, r->value);
+				++r;
+			}
+			else
+			{
+				if (l->value != r->value)
+					report(r->position, r->value);
+				++l;
+				++r;
+			}
+		}
+		coalescer.flush(emit);
+
+		for (const auto& found : derived)
+			origins.push_back(std::lower_bound(starts.begin(), starts.end(), std::make_pair(found.start, std::size_t{0}))->second);
+	};
+
+	auto spans = detail::unresolved_spans(lhs, rhs);
+	auto windows = detail::merge_windows(spans);
+	derive(windows);
+
+	// Clusters the refiner would realign go to the engine too, grouped by
+	// the refiner's own rule.
+	auto suspicious = spans.size();
+	for (std::size_t first = 0, i = 0, bases = 0; i <= derived.size(); ++i)
+	{
+		if (i == derived.size() || (i > first && detail::breaks_cluster(derived[first], derived[i])))
+		{
+			if (detail::suspicious_cluster(bases))
+				spans.push_back(detail::variant_window{origins[first], origins[i - 1] + derived[i - 1].length});
+			first = i;
+			bases = 0;
+		}
+		if (i < derived.size())
+			bases += derived[i].length;
+	}
+	if (spans.size() > suspicious)
+	{
+		windows = detail::merge_windows(spans);
+		derive(windows);
+	}
+
+	std::vector<difference> result;
+	auto emit = [&](const difference& found) { result.push_back(found); };
+	std::size_t next = 0;
+	for (const auto& each : windows)
+	{
+		for (; next < derived.size() && origins[next] < each.from; ++next)
+			result.push_back(derived[next]);
+		resolve(alignment_frame{lhs_walk.at(each.from), rhs_walk.at(each.from), lhs_walk.at(each.to), rhs_walk.at(each.to)},
+				emit);
+	}
+	result.insert(result.end(), derived.begin() + static_cast<long>(next), derived.end());
+	return result;
+}
+
+inline std::vector<difference> stored_variants(const difference_store& store, std::size_t chromosome)
+{
+	std::vector<difference> result;
+	store.scan(chromosome, 0, std::numeric_limits<std::size_t>::max(),
+			[&](const difference& found) { result.push_back(found); });
+	return result;
+}
+
+// Derives the pair's differences from their stored variant lists, comparing
+// the two people directly only inside the windows the lists can't settle.
+template<Person P>
+std::vector<difference> compare_chromosome_by_variants(const P& lhs, const difference_store& lhs_variants,
+		const P& rhs, const difference_store& rhs_variants, const P& reference, std::size_t chromosome)
+{
+	helix_of<P> reference_helix = reference.chromosome(chromosome);
+	helix_of<P> lhs_helix = lhs.chromosome(chromosome);
+	helix_of<P> rhs_helix = rhs.chromosome(chromosome);
+	auto lhs_shift = frame_helices(reference_helix, lhs_helix).offset();
+	auto rhs_shift = frame_helices(reference_helix, rhs_helix).offset();
+	auto frame = frame_helices(lhs_helix, rhs_helix);
+
+	return compare_variant_lists(stored_variants(lhs_variants, chromosome), lhs_shift,
+			stored_variants(rhs_variants, chromosome), rhs_shift, reference_helix, chromosome,
+			[&](alignment_frame window, auto& emit)
+			{
+				auto skip = window.lhs_begin < frame.lhs_begin ? frame.lhs_begin - window.lhs_begin : 0;
+				window.lhs_begin += skip;
+				window.rhs_begin += skip;
+				window.lhs_end = std::min(window.lhs_end, frame.lhs_end);
+				window.rhs_end = std::min(window.rhs_end, frame.rhs_end);
+				if (window.lhs_begin >= window.lhs_end || window.rhs_begin >= window.rhs_end)
+					return;
+
+				auto map = map_alignment(lhs_helix, rhs_helix, window);
+				compare_mapped(lhs_helix, rhs_helix, chromosome, map, emit);
+			});
+}
+
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <functional>
+#include <limits>
+#include <queue>
+#include "difference_store.hpp"
+#include "parallel.hpp"
+#include "posting_list.hpp"
+#include "variant.hpp"
+
+namespace dna
+{
+
+// Who carries each variant, given one store per person of their differences
+// against a shared reference. Person ids are positions in the store list.
+class variant_index
+{
+public:
+	struct entry
+	{
+		variant key;
+		posting_list carriers;
+	};
+
+private:
+	std::vector<std::vector<entry>> chromosomes_;
+
+	const std::vector<entry>* entries(std::size_t chromosome) const noexcept
+	{
+		return chromosome < chromosomes_.size() ? &chromosomes_[chromosome] : nullptr;
+	}
+public:
+	explicit variant_index(std::vector<std::vector<entry>> chromosomes) :
+			chromosomes_(std::move(chromosomes))
+	{ }
+
+	std::size_t size() const noexcept
+	{
+		std::size_t total = 0;
+		for (const auto& each : chromosomes_)
+			total += each.size();
+		return total;
+	}
+
+	posting_list carriers(const variant& key) const
+	{
+		auto list = entries(key.chromosome);
+		if (!list)
+			return {};
+
+		auto found = std::lower_bound(list->begin(), list->end(), key,
+				[](const entry& each, const variant& wanted) { return each.key < wanted; });
+		if (found == list->end() || found->key != key)
+			return {};
+		return found->carriers;
+	}
+
+	// Everyone with any allele starting at `position`. Substitutions are kept
+	// per base, so this finds a SNP inside a longer run too.
+	posting_list carriers_at(std::size_t chromosome, std::size_t position) const
+	{
+		posting_list result;
+		auto list = entries(chromosome);
+		if (!list)
+			return result;
+
+		auto found = std::lower_bound(list->begin(), list->end(), position,
+				[](const entry& each, std::size_t wanted) { return each.key.position < wanted; });
+		for (; found != list->end() && found->key.position == position; ++found)
+			result = result | found->carriers;
+		return result;
+	}
+};
+
+namespace detail
+{
+
+// Walks the alleles one store holds on a chromosome, decoding a block at a
+// time. Alleles come out in position order.
+class allele_cursor
+{
+	const difference_store* store_;
+	std::size_t chromosome_;
+	std::size_t block_;
+	std::vector<variant> alleles_;
+	std::size_t next_;
+
+	void fill()
+	{
+		while (next_ == alleles_.size() && block_ < store_->blocks())
+		{
+			auto entry = store_->block(block_++);
+			if (entry.first_chromosome > chromosome_)
+			{
+				block_ = store_->blocks();
+				break;
+			}
+
+			alleles_.clear();
+			next_ = 0;
+			store_->decode_block(block_ - 1, [&](const difference& found)
+			{
+				if (found.chromosome == chromosome_)
+					for_each_allele(found, [&](const variant& allele) { alleles_.push_back(allele); });
+			});
+		}
+	}
+public:
+	allele_cursor(const difference_store& store, std::size_t chromosome) :
+			store_(&store),
+			chromosome_(chromosome),
+			block_(store.first_block(chromosome)),
+			alleles_(),
+			next_(0)
+	{
+		fill();
+	}
+
+	bool done() const noexcept
+	{
+		return next_ == alleles_.size();
+	}
+
+	const variant& current() const noexcept
+	{
+		return alleles_[next_];
+	}
+
+	void advance()
+	{
+		++next_;
+		fill();
+	}
+};
+
+}
+
+// One task per chromosome; each merges that chromosome's alleles across every
+// store a block at a time, so only one position's worth of carriers is ever
+// gathered before it becomes entries.
+inline variant_index build_variant_index(const std::vector<std::reference_wrapper<const difference_store>>& people,
+		std::size_t threads = default_threads())
+{
+	if (people.size() > std::numeric_limits<std::uint32_t>::max())
+		throw std::invalid_argument("too many people for a variant index");
+
+	std::size_t chromosomes = 0;
+	for (const auto& store : people)
+		chromosomes = std::max(chromosomes, store.get().chromosomes());
+
+	std::vector<std::vector<variant_index::entry>> result(chromosomes);
+	parallel_for(chromosomes, threads, [&](std::size_t chromosome)
+	{
+		using head = std::pair<std::size_t, std::uint32_t>;
+
+		std::vector<detail::allele_cursor> cursors;
+		std::priority_queue<head, std::vector<head>, std::greater<head>> heads;
+		cursors.reserve(people.size());
+		for (std::size_t person = 0; person < people.size(); ++person)
+		{
+			cursors.emplace_back(people[person].get(), chromosome);
+			if (!cursors.back().done())
+				heads.emplace(cursors.back().current().position, static_cast<std::uint32_t>(person));
+		}
+
+		// Alleles at one position may differ in kind and length, and one
+		// person's come in store order rather than key order, so each
+		// position is gathered and sorted before it becomes entries.
+		auto& entries = result[chromosome];
+		std::vector<std::pair<variant, std::uint32_t>> found;
+		while (!heads.empty())
+		{
+			auto position = heads.top().first;
+			found.clear();
+			while (!heads.empty() && heads.top().first == position)
+			{
+				auto person = heads.top().second;
+				heads.pop();
+
+				auto& cursor = cursors[person];
+				for (; !cursor.done() && cursor.current().position == position; cursor.advance())
+					found.emplace_back(cursor.current(), person);
+				if (!cursor.done())
+					heads.emplace(cursor.current().position, person);
+			}
+
+			std::sort(found.begin(), found.end());
+			for (const auto& [key, person] : found)
+			{
+				if (entries.empty() || entries.back().key != key)
+					entries.push_back(variant_index::entry{key, {}});
+				if (entries.back().carriers.empty() || !entries.back().carriers.contains(person))
+					entries.back().carriers.push_back(person);
+			}
+		}
+	});
+
+	return variant_index(std::move(result));
+}
+
+}